@@ -0,0 +1,205 @@
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#pragma once
+#include "game_state.hpp"
+#include "move.hpp"
+#include "pieces.hpp"
+#include "rules.hpp"
+
+/// @brief 探索しながら数える集計の種類
+/// - occupancy: 終局した局面で各マスを埋めたプレイヤーと, 埋めたターン
+/// - remaining: 終局した局面で各プレイヤーが使っていないブロックの数と種類
+/// - usage: ターンごとに置いた向き (ORIENTATIONS の添字) の回数
+struct AggregateOptions {
+    bool occupancy = true;
+    bool remaining = true;
+    bool usage = true;
+
+    /// @brief "occupancy,remaining,usage" のようにカンマ区切りで並べた
+    /// 種類だけを数える設定を返す
+    static AggregateOptions parse(const std::string &text) {
+        AggregateOptions options{false, false, false};
+        std::istringstream stream(text);
+        std::string kind;
+        while (std::getline(stream, kind, ',')) {
+            if (kind == "occupancy") {
+                options.occupancy = true;
+            } else if (kind == "remaining") {
+                options.remaining = true;
+            } else if (kind == "usage") {
+                options.usage = true;
+            } else {
+                throw std::invalid_argument("Invalid aggregate: " + kind);
+            }
+        }
+        return options;
+    }
+};
+
+/// @brief ルール Rules の探索で, 局面を書き出す代わりにその場で数える集計.
+/// 終局した局面 (完全なゲームと, 手番のプレイヤーが置けずに終わった局面)
+/// ごとに count_end, ブロックを置くごとに count_move を呼ぶ.
+/// スレッドごとに数えて += で合わせ, write で 1 つのテキストに書き出す.
+/// 表は AggregateOptions で選んだ種類の分だけ確保する
+template <class Rules>
+class BasicGameAggregates {
+    using GameState = BasicGameState<Rules>;
+    static constexpr std::size_t FIELD_WIDTH = Rules::FIELD_WIDTH;
+    static constexpr std::size_t CELL_SIZE = FIELD_WIDTH * FIELD_WIDTH;
+    static constexpr unsigned short PLAYER_SIZE = Rules::PLAYER_SIZE;
+    static constexpr unsigned short MAX_TURN = rule_max_turn<Rules>();
+    // 1 人のプレイヤーが使うブロックの数
+    static constexpr unsigned short PLAYER_BLOCK_SIZE =
+        rule_block_size<Rules>();
+
+    AggregateOptions _options;
+    // 終局した局面の数と, そのうち完全なゲームの数
+    unsigned long long _games = 0;
+    unsigned long long _complete_games = 0;
+    // _player_cells[p * CELL_SIZE + c] := マス c をプレイヤー p が埋めた数
+    std::vector<unsigned long long> _player_cells;
+    // _turn_cells[(t - 1) * CELL_SIZE + c] := マス c をターン t に埋めた数
+    std::vector<unsigned long long> _turn_cells;
+    // _remaining_counts[p * (PLAYER_BLOCK_SIZE + 1) + k]
+    //   := プレイヤー p が k 個のブロックを残して終わった数
+    std::vector<unsigned long long> _remaining_counts;
+    // _unused_blocks[p * BLOCK_SIZE + b] := プレイヤー p がブロック b を
+    // 残して終わった数
+    std::vector<unsigned long long> _unused_blocks;
+    // _usage[(t - 1) * ORIENTATION_SIZE + o] := ターン t に向き o を置いた数
+    std::vector<unsigned long long> _usage;
+
+   public:
+    explicit BasicGameAggregates(AggregateOptions options = {})
+        : _options(options) {
+        if (_options.occupancy) {
+            _player_cells.resize(PLAYER_SIZE * CELL_SIZE);
+            _turn_cells.resize(MAX_TURN * CELL_SIZE);
+        }
+        if (_options.remaining) {
+            _remaining_counts.resize(PLAYER_SIZE * (PLAYER_BLOCK_SIZE + 1));
+            _unused_blocks.resize(PLAYER_SIZE * BLOCK_SIZE);
+        }
+        if (_options.usage) {
+            _usage.resize(MAX_TURN * ORIENTATION_SIZE);
+        }
+    }
+
+    const AggregateOptions &options() const { return _options; }
+    unsigned long long games() const { return _games; }
+    unsigned long long complete_games() const { return _complete_games; }
+
+    /// @brief ターン turn (1 以上) に move を置いたことを数える
+    void count_move(unsigned short turn, const Move &move) {
+        if (_options.usage) {
+            _usage[(turn - 1) * ORIENTATION_SIZE + move.orientation]++;
+        }
+    }
+
+    /// @brief 初手から path の手順で終局した局面 state を数える
+    void count_end(const GameState &state, const std::vector<Move> &path) {
+        _games++;
+        if (state.is_all_blocks_used()) {
+            _complete_games++;
+        }
+        if (_options.occupancy) {
+            for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
+                state.boards[player].for_each([&](std::size_t cell) {
+                    _player_cells[player * CELL_SIZE + cell]++;
+                });
+            }
+            for (std::size_t i = 0; i < path.size(); i++) {
+                const Move &move = path[i];
+                const Orientation &block = ORIENTATIONS[move.orientation];
+                for (unsigned short j = 0; j < block.cell_size; j++) {
+                    const std::size_t cell =
+                        (move.position.x + block.cells[j].x) * FIELD_WIDTH +
+                        move.position.y + block.cells[j].y;
+                    _turn_cells[i * CELL_SIZE + cell]++;
+                }
+            }
+        }
+        if (_options.remaining) {
+            for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
+                _remaining_counts[player * (PLAYER_BLOCK_SIZE + 1) +
+                                  state.blocks_left(player)]++;
+                for (unsigned short block = 0; block < BLOCK_SIZE; block++) {
+                    if ((state.remaining[player] >> block) & 1) {
+                        _unused_blocks[player * BLOCK_SIZE + block]++;
+                    }
+                }
+            }
+        }
+    }
+
+    /// @brief other (同じ種類を数えたもの) の集計を足す
+    BasicGameAggregates &operator+=(const BasicGameAggregates &other) {
+        _games += other._games;
+        _complete_games += other._complete_games;
+        add(_player_cells, other._player_cells);
+        add(_turn_cells, other._turn_cells);
+        add(_remaining_counts, other._remaining_counts);
+        add(_unused_blocks, other._unused_blocks);
+        add(_usage, other._usage);
+        return *this;
+    }
+
+    /// @brief 集計を 1 行に 1 つの表として書き出す.
+    /// マスの値は x * FIELD_WIDTH + y の順に並べ, すべて 0 の行は省く
+    /// - occupancy_player p: プレイヤー p がマスを埋めた数
+    /// - occupancy_turn t: ターン t にマスを埋めた数
+    /// - remaining_count p: ブロックを 0, 1, ... 個残して終わった数
+    /// - unused_block p: ブロック 0, 1, ... を残して終わった数
+    /// - usage t: ターン t に向き 0, 1, ... を置いた数
+    void write(std::ostream &stream) const {
+        stream << "field_width " << FIELD_WIDTH << '\n';
+        stream << "players " << PLAYER_SIZE << '\n';
+        stream << "games " << _games << '\n';
+        stream << "complete_games " << _complete_games << '\n';
+        write_rows(stream, "occupancy_player", _player_cells, CELL_SIZE, 0);
+        write_rows(stream, "occupancy_turn", _turn_cells, CELL_SIZE, 1);
+        write_rows(stream, "remaining_count", _remaining_counts,
+                   PLAYER_BLOCK_SIZE + 1, 0);
+        write_rows(stream, "unused_block", _unused_blocks, BLOCK_SIZE, 0);
+        write_rows(stream, "usage", _usage, ORIENTATION_SIZE, 1);
+    }
+
+   private:
+    static void add(std::vector<unsigned long long> &values,
+                    const std::vector<unsigned long long> &other) {
+        if (values.size() != other.size()) {
+            throw std::invalid_argument("Mismatched aggregate options");
+        }
+        for (std::size_t i = 0; i < values.size(); i++) {
+            values[i] += other[i];
+        }
+    }
+
+    /// @brief values を width 個ずつの行として, 行の番号 (first から) を
+    /// 付けて書き出す
+    static void write_rows(std::ostream &stream, const char *name,
+                           const std::vector<unsigned long long> &values,
+                           std::size_t width, std::size_t first) {
+        for (std::size_t row = 0; row * width < values.size(); row++) {
+            bool any = false;
+            for (std::size_t i = 0; i < width; i++) {
+                any = any or values[row * width + i] != 0;
+            }
+            if (!any) {
+                continue;
+            }
+            stream << name << ' ' << row + first;
+            for (std::size_t i = 0; i < width; i++) {
+                stream << ' ' << values[row * width + i];
+            }
+            stream << '\n';
+        }
+    }
+};
+
+using GameAggregates = BasicGameAggregates<ClassicRules>;
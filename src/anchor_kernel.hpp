@@ -0,0 +1,214 @@
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#pragma once
+#include "pieces.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// AVX2 のレジスタ 1 つに入る 64 bit 整数の数. 計算はこの単位で行う
+constexpr std::size_t ANCHOR_LANE_SIZE = 4;
+
+/// @brief board_word_size 語のビットボードの左上のマスの集合を表す
+/// 64 bit 整数の数. ANCHOR_LANE_SIZE の倍数に切り上げる
+/// (20 x 20 のフィールドなら AVX2 のレジスタ 2 つ分, 14 x 14 なら 1 つ分)
+constexpr std::size_t anchor_word_size(std::size_t board_word_size) {
+    return (board_word_size + ANCHOR_LANE_SIZE - 1) / ANCHOR_LANE_SIZE *
+           ANCHOR_LANE_SIZE;
+}
+// ブロックのマスがバウンディングボックス内で取りうる位置の数
+constexpr std::size_t ANCHOR_SHIFT_SIZE =
+    MAX_BLOCK_CELL_SIZE * MAX_BLOCK_CELL_SIZE;
+
+// ANCHOR_SHIFT_USED[k] := バウンディングボックス内の位置 k
+// にマスを持つ向きがあるかどうか. 使わない位置の盤面はずらさない
+constexpr std::array<bool, ANCHOR_SHIFT_SIZE> ANCHOR_SHIFT_USED = [] {
+    std::array<bool, ANCHOR_SHIFT_SIZE> used{};
+    for (const Orientation &orientation : ORIENTATIONS) {
+        for (unsigned short i = 0; i < orientation.cell_size; i++) {
+            used[orientation.cells[i].x * MAX_BLOCK_CELL_SIZE +
+                 orientation.cells[i].y] = true;
+        }
+    }
+    return used;
+}();
+
+/// @brief 左上のマスの集合. ビット a が左上をマス a に置くことを表す.
+/// 以下のテンプレートの WORD_SIZE は anchor_word_size で求めた語の数
+template <std::size_t WORD_SIZE>
+using AnchorWords = std::array<std::uint64_t, WORD_SIZE>;
+
+/// @brief columns[y] := 左上に置いたマスから右に y 列ずれたマスが,
+/// フィールドの右端を越えずに同じ行に収まる左上のマス.
+/// 盤面を y だけずらしたときに, 前の行から回り込んだビットを落とす
+template <std::size_t WORD_SIZE>
+using AnchorColumns = std::array<AnchorWords<WORD_SIZE>, MAX_BLOCK_CELL_SIZE>;
+
+/// @brief ビットボードを 64 bit 整数 2 * WORD_SIZE 個に広げた作業領域.
+/// 盤面を先頭に置き, 残りは 0 にしておく. 先頭 WORD_SIZE 語を
+/// 64 * (WORD_SIZE - 1) ビットまで右にずらして読み出せる
+template <std::size_t WORD_SIZE>
+struct alignas(32) AnchorBoard {
+    std::array<std::uint64_t, 2 * WORD_SIZE> words{};
+
+    constexpr AnchorBoard() {}
+
+    template <class Board>
+    constexpr explicit AnchorBoard(const Board &board) {
+        static_assert(Board::WORD_SIZE <= WORD_SIZE);
+        for (std::size_t i = 0; i < Board::WORD_SIZE; i++) {
+            words[i] = board.word(i);
+        }
+    }
+};
+
+/// @brief 立っているビットの位置を小さい順に f に渡す
+template <std::size_t WORD_SIZE, class F>
+void for_each_anchor(const AnchorWords<WORD_SIZE> &anchors, F &&f) {
+    for (std::size_t i = 0; i < WORD_SIZE; i++) {
+        std::uint64_t word = anchors[i];
+        while (word != 0) {
+            f(i * 64 + std::countr_zero(word));
+            word &= word - 1;
+        }
+    }
+}
+
+template <std::size_t WORD_SIZE>
+std::size_t count_anchors(const AnchorWords<WORD_SIZE> &anchors) {
+    std::size_t result = 0;
+    for (std::uint64_t word : anchors) {
+        result += std::popcount(word);
+    }
+    return result;
+}
+
+/// @brief 1 つの盤面をブロックのマスの位置だけ右にずらしたもの.
+/// k 番目は, バウンディングボックス内の位置 k = x * MAX_BLOCK_CELL_SIZE + y
+/// のマスの分 (x * width + y ビット) だけずらしたもの. 左上を a
+/// としたとき, そのマスは a + x * width + y を覆うので, k 番目のビット a
+/// がそのマスの状態になる.
+/// ずらす量 x * width + y は 64 * WORD_SIZE 未満であること
+template <std::size_t WORD_SIZE>
+class ShiftedBoard {
+    alignas(32) std::array<AnchorWords<WORD_SIZE>, ANCHOR_SHIFT_SIZE> _shifted;
+
+   public:
+    /// @param width フィールドの横の長さ
+    /// @param columns 渡せば, 位置 (x, y) の分ずらしたものを columns[y]
+    /// で絞り, 列をまたいで回り込んだビットを落とす
+    ShiftedBoard(const AnchorBoard<WORD_SIZE> &board, std::size_t width,
+                 const AnchorColumns<WORD_SIZE> *columns = nullptr) {
+        for (std::size_t x = 0; x < MAX_BLOCK_CELL_SIZE; x++) {
+            for (std::size_t y = 0; y < MAX_BLOCK_CELL_SIZE; y++) {
+                const std::size_t k = x * MAX_BLOCK_CELL_SIZE + y;
+                if (!ANCHOR_SHIFT_USED[k]) {
+                    continue;
+                }
+                const std::size_t offset = x * width + y;
+                const std::size_t word_shift = offset / 64;
+                const std::size_t bit_shift = offset % 64;
+                for (std::size_t j = 0; j < WORD_SIZE; j++) {
+                    const std::uint64_t low = board.words[j + word_shift];
+                    const std::uint64_t high = board.words[j + word_shift + 1];
+                    _shifted[k][j] =
+                        bit_shift == 0
+                            ? low
+                            : (low >> bit_shift) | (high << (64 - bit_shift));
+                    if (columns != nullptr) {
+                        _shifted[k][j] &= (*columns)[y][j];
+                    }
+                }
+            }
+        }
+    }
+
+    /// @brief バウンディングボックス内の位置が shifts[0..cell_size)
+    /// のマスからなるブロックについて, 各位置の OR を result に書く.
+    /// ビット a が立つのは, 左上を a としたときにブロックが盤面の立っている
+    /// マスのいずれかを覆うとき. AVX2 が使えれば 256 ビットずつ計算する
+    void cover(const unsigned char *shifts, unsigned short cell_size,
+               AnchorWords<WORD_SIZE> &result) const {
+        for (std::size_t lane = 0; lane < WORD_SIZE; lane += ANCHOR_LANE_SIZE) {
+#ifdef __AVX2__
+            __m256i value = _mm256_setzero_si256();
+            for (unsigned short i = 0; i < cell_size; i++) {
+                value = _mm256_or_si256(
+                    value, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(
+                               _shifted[shifts[i]].data() + lane)));
+            }
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i *>(result.data() + lane), value);
+#else
+            for (std::size_t j = lane; j < lane + ANCHOR_LANE_SIZE; j++) {
+                std::uint64_t value = 0;
+                for (unsigned short i = 0; i < cell_size; i++) {
+                    value |= _shifted[shifts[i]][j];
+                }
+                result[j] = value;
+            }
+#endif
+        }
+    }
+};
+
+/// @brief 1 つの向きのブロックについて, 左上を置けるマスをすべて同時に求めた結果.
+/// - legal: 左上を置けるマス
+/// - out_of_field, occupied, edge_adjacent, no_diagonal_contact:
+///   それぞれの理由で置けない左上のマスの数 (RejectReason)
+template <std::size_t WORD_SIZE>
+struct AnchorScan {
+    AnchorWords<WORD_SIZE> legal{};
+    std::size_t out_of_field = 0;
+    std::size_t occupied = 0;
+    std::size_t edge_adjacent = 0;
+    std::size_t no_diagonal_contact = 0;
+};
+
+/// @brief 1 人のプレイヤーについて, 配置の可否の判定に使う盤面をずらしたもの
+/// - blocked: 占有されたマスと, 自分のブロックと辺で接するマス
+/// - occupied: 占有されたマス (置けない理由の内訳にだけ使う)
+/// - corners: 自分のブロックと斜めに接する, 使える角のマス.
+///   はみ出る左上のマスの理由にも使うので, 回り込んだビットを落とす
+template <std::size_t WORD_SIZE>
+class AnchorShifts {
+    ShiftedBoard<WORD_SIZE> _blocked, _occupied, _corners;
+
+   public:
+    AnchorShifts(const AnchorBoard<WORD_SIZE> &blocked,
+                 const AnchorBoard<WORD_SIZE> &occupied,
+                 const AnchorBoard<WORD_SIZE> &corners, std::size_t width,
+                 const AnchorColumns<WORD_SIZE> &columns)
+        : _blocked(blocked, width),
+          _occupied(occupied, width),
+          _corners(corners, width, &columns) {}
+
+    /// @brief すべての左上のマスについて配置の可否を一度に求める.
+    /// blocked を覆わず, corners を覆う左上のマスが置けるマスになる.
+    /// fits は左上に置いてもブロックがフィールドからはみ出ないマスで,
+    /// blocked と occupied の列をまたいで回り込んだビットはこれで落とす
+    void scan(const AnchorWords<WORD_SIZE> &fits, const unsigned char *shifts,
+              unsigned short cell_size, AnchorScan<WORD_SIZE> &result) const {
+        alignas(32) AnchorWords<WORD_SIZE> bad, taken, touch;
+        _blocked.cover(shifts, cell_size, bad);
+        _occupied.cover(shifts, cell_size, taken);
+        _corners.cover(shifts, cell_size, touch);
+        result.out_of_field = result.occupied = result.edge_adjacent =
+            result.no_diagonal_contact = 0;
+        for (std::size_t j = 0; j < WORD_SIZE; j++) {
+            const std::uint64_t inside = touch[j] & fits[j];
+            result.legal[j] = inside & ~bad[j];
+            result.out_of_field += std::popcount(touch[j] & ~fits[j]);
+            result.no_diagonal_contact += std::popcount(fits[j] & ~touch[j]);
+            // 使える角を覆う置き方はほとんどの語で無い
+            if (inside == 0) {
+                continue;
+            }
+            result.occupied += std::popcount(inside & taken[j]);
+            result.edge_adjacent += std::popcount(inside & bad[j] & ~taken[j]);
+        }
+    }
+};
@@ -0,0 +1,224 @@
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "field.hpp"
+#include "mailbox_field.hpp"
+#include "move.hpp"
+#include "pieces.hpp"
+#include "players.hpp"
+#include "solver.hpp"
+
+/// @brief ベンチマークに使う局面. moves を初手から順に置いた局面から
+/// depth 手先まで数え, 手数ごとの局面の数が counts と一致するか確かめる
+struct BenchmarkPosition {
+    std::string name;
+    std::vector<Move> moves;
+    unsigned short depth;
+    // counts[i] := i 手目の局面の数. 合法手の生成を変えたときはここと照合する
+    std::vector<unsigned long long> counts;
+};
+
+const std::vector<BenchmarkPosition> BENCHMARK_POSITIONS = {
+    {"empty", {}, 4, {1, 58, 3364, 195112, 11316496}},
+    {"opening",
+     {{73, {0, 17}}, {3, {17, 19}}, {14, {18, 0}}, {55, {0, 0}},
+      {65, {3, 14}}, {1, {15, 18}}, {76, {15, 0}}, {67, {2, 3}}},
+     3,
+     {1, 489, 107090, 24844880}},
+    {"middle",
+     {{37, {0, 15}},  {76, {17, 17}}, {19, {18, 0}},  {69, {0, 0}},
+      {17, {1, 12}},  {86, {15, 15}}, {4, {19, 3}},   {28, {3, 1}},
+      {12, {3, 9}},   {90, {12, 14}}, {44, {15, 6}},  {38, {6, 1}},
+      {80, {2, 15}},  {24, {14, 17}}, {83, {18, 7}},  {86, {10, 0}},
+      {56, {6, 14}},  {19, {14, 11}}, {37, {16, 8}},  {61, {14, 0}}},
+     3,
+     {1, 626, 169884, 37609772}},
+    {"endgame",
+     {{80, {0, 18}},  {39, {18, 16}}, {77, {17, 0}},  {10, {0, 0}},
+      {87, {2, 16}},  {75, {15, 17}}, {25, {14, 2}},  {53, {4, 0}},
+      {7, {3, 14}},   {57, {15, 14}}, {20, {11, 0}},  {68, {2, 4}},
+      {75, {1, 11}},  {29, {12, 17}}, {2, {19, 2}},   {63, {5, 4}},
+      {39, {5, 16}},  {51, {18, 12}}, {9, {10, 2}},   {31, {6, 7}},
+      {12, {0, 10}},  {24, {18, 9}},  {4, {9, 6}},    {19, {4, 7}},
+      {18, {1, 8}},   {19, {13, 13}}, {34, {11, 5}},  {13, {1, 10}},
+      {67, {7, 14}},  {3, {10, 12}},  {48, {9, 9}},   {37, {6, 10}},
+      {71, {10, 14}}, {78, {15, 8}},  {61, {16, 4}},  {0, {1, 12}},
+      {9, {8, 10}},   {67, {9, 18}},  {11, {13, 10}}, {85, {0, 5}}},
+     3,
+     {1, 27, 2283, 193095}},
+};
+
+/// @brief f を実行した秒数を返す
+template <class F>
+double measure(F &&f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void report(const std::string &name, const std::string &target,
+            unsigned long long operations, double seconds) {
+    std::cout << std::left << std::setw(10) << name << std::setw(20) << target
+              << std::right << std::setw(12) << operations << " ops "
+              << std::fixed << std::setprecision(3) << std::setw(8) << seconds
+              << " s " << std::setprecision(0) << std::setw(14)
+              << operations / seconds << " ops/s" << std::endl;
+}
+
+/// @brief 局面の盤面を用意する
+template <class Field>
+void setup(const BenchmarkPosition &position, Field &field) {
+    for (const Move &move : position.moves) {
+        const Player player =
+            static_cast<Player>(field.current_turn % PLAYER_SIZE);
+        field.place(move.position.x, move.position.y, move.orientation, player);
+    }
+}
+
+/// @brief 手番のプレイヤーについて, すべての向きとマスで is_able_to_place
+/// を呼ぶ. 置ける数が generate_moves の合法手の数と一致するか確かめる
+template <class Field>
+bool bench_is_able_to_place(const BenchmarkPosition &position,
+                            unsigned rounds) {
+    Field field;
+    setup(position, field);
+    const Player player = static_cast<Player>(field.current_turn % PLAYER_SIZE);
+
+    std::size_t placeable = 0;
+    unsigned long long calls = 0;
+    const double seconds = measure([&] {
+        for (unsigned round = 0; round < rounds; round++) {
+            placeable = 0;
+            for (unsigned short orientation = 0;
+                 orientation < ORIENTATION_SIZE; orientation++) {
+                if (field.state().is_used(player,
+                                          ORIENTATIONS[orientation].block)) {
+                    continue;
+                }
+                calls += FIELD_CELL_SIZE;
+                for (unsigned short x = 0; x < FIELD_WIDTH; x++) {
+                    for (unsigned short y = 0; y < FIELD_WIDTH; y++) {
+                        placeable +=
+                            field.is_able_to_place(x, y, orientation, player);
+                    }
+                }
+            }
+        }
+    });
+    report(position.name, "is_able_to_place", calls, seconds);
+
+    std::vector<Move> moves;
+    field.generate_moves(player, moves);
+    if (placeable != moves.size()) {
+        std::cerr << position.name << ": is_able_to_place found " << placeable
+                  << " moves, generate_moves found " << moves.size()
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// @brief 手番のプレイヤーの合法手をそれぞれ置いて取り除く
+template <class Field>
+void bench_place_remove(const BenchmarkPosition &position, unsigned rounds) {
+    Field field;
+    setup(position, field);
+    const Player player = static_cast<Player>(field.current_turn % PLAYER_SIZE);
+    std::vector<Move> moves;
+    field.generate_moves(player, moves);
+
+    const double seconds = measure([&] {
+        for (unsigned round = 0; round < rounds; round++) {
+            for (const Move &move : moves) {
+                field.place(move.position.x, move.position.y,
+                            move.orientation, player);
+                field.remove(move.position.x, move.position.y,
+                             move.orientation);
+            }
+        }
+    });
+    report(position.name, "place/remove",
+           static_cast<unsigned long long>(rounds) * moves.size(), seconds);
+}
+
+/// @brief depth 手先まで数え, 記録した局面の数と一致するか確かめる
+template <template <class> class FieldType>
+bool bench_search(const BenchmarkPosition &position) {
+    BasicSolver<ClassicRules, FieldType> solver;
+    std::vector<unsigned long long> counts;
+    const double seconds =
+        measure([&] { counts = solver.count(position.moves, position.depth); });
+    unsigned long long nodes = 0;
+    for (std::size_t depth = 1; depth < counts.size(); depth++) {
+        nodes += counts[depth];
+    }
+    report(position.name, "search (depth " + std::to_string(position.depth) +
+                              ")",
+           nodes, seconds);
+
+    if (counts != position.counts) {
+        std::cerr << position.name << ": node counts differ:";
+        for (unsigned long long count : counts) {
+            std::cerr << ' ' << count;
+        }
+        std::cerr << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// @brief 2 手先まで展開する (Solver::split). 2 手目の局面では合法手を
+/// 生成しないので, 実際の探索と同じく place と remove の速さも効く.
+/// ブロックを置いた数が記録した局面の数と一致するか確かめる
+template <template <class> class FieldType>
+bool bench_split(const BenchmarkPosition &position) {
+    BasicSolver<ClassicRules, FieldType> solver;
+    solver.set_save_positions(false);
+    std::vector<std::vector<Move>> prefixes;
+    const double seconds =
+        measure([&] { solver.split(position.moves, 2, prefixes); });
+    const unsigned long long nodes = solver.stats().total_steps;
+    report(position.name, "split (depth 2)", nodes, seconds);
+
+    if (nodes != position.counts[1] + position.counts[2]) {
+        std::cerr << position.name << ": split placed " << nodes
+                  << " blocks" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// @brief フィールドの実装 FieldType で, 記録した局面の各処理の速さを測り,
+/// 局面の数を照合する
+/// @return 照合に成功したかどうか
+template <template <class> class FieldType>
+bool bench_field(const std::string &name) {
+    using Field = FieldType<ClassicRules>;
+    std::cout << "field: " << name << std::endl;
+    bool ok = true;
+    for (const BenchmarkPosition &position : BENCHMARK_POSITIONS) {
+        ok &= bench_is_able_to_place<Field>(position, 200);
+        bench_place_remove<Field>(position, 2000);
+        ok &= bench_search<FieldType>(position);
+        ok &= bench_split<FieldType>(position);
+    }
+    return ok;
+}
+
+/// @brief ビットボードとメールボックスのフィールドで同じ処理の速さを測り,
+/// 局面の数を照合する. 照合に失敗したら 1 を返す
+int main() {
+    bool ok = bench_field<BasicField>("bitboard");
+    ok &= bench_field<BasicMailboxField>("mailbox");
+    if (!ok) {
+        std::cerr << "Benchmark results do not match the reference counts"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
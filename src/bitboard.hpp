@@ -0,0 +1,169 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief BITS ビットの集合を 64 bit 整数の配列で表すビットボード.
+/// フィールドのマス (x, y) は x * FIELD_WIDTH + y 番目のビットに対応させて使う.
+/// BITS 以上の位置のビットは常に 0 に保たれる.
+template <std::size_t BITS>
+class Bitboard {
+  public:
+    static constexpr std::size_t WORD_SIZE = (BITS + 63) / 64;
+
+  private:
+    // 末尾のワードのうち, 有効なビットだけが立ったマスク
+    static constexpr std::uint64_t LAST_WORD_MASK =
+        BITS % 64 == 0 ? ~std::uint64_t{0}
+                       : (std::uint64_t{1} << (BITS % 64)) - 1;
+
+    std::array<std::uint64_t, WORD_SIZE> _words{};
+
+  public:
+    constexpr Bitboard() {}
+
+    constexpr bool test(std::size_t index) const {
+        return (_words[index / 64] >> (index % 64)) & 1;
+    }
+    constexpr void set(std::size_t index) {
+        _words[index / 64] |= std::uint64_t{1} << (index % 64);
+    }
+    constexpr void reset(std::size_t index) {
+        _words[index / 64] &= ~(std::uint64_t{1} << (index % 64));
+    }
+
+    constexpr std::uint64_t word(std::size_t index) const {
+        return _words[index];
+    }
+
+    /// @brief index 番目のビットから始まる 128 ビットを取り出す.
+    /// 小さなブロックとの AND を, ビットボード全体をずらさずに取るのに使う
+    constexpr unsigned __int128 window(std::size_t index) const {
+        const std::size_t word_index = index / 64;
+        const std::size_t bit_shift = index % 64;
+        const std::uint64_t w0 = _words[word_index];
+        const std::uint64_t w1 =
+            word_index + 1 < WORD_SIZE ? _words[word_index + 1] : 0;
+        const std::uint64_t w2 =
+            word_index + 2 < WORD_SIZE ? _words[word_index + 2] : 0;
+        const unsigned __int128 low =
+            (static_cast<unsigned __int128>(w1) << 64) | w0;
+        if(bit_shift == 0) {
+            return low;
+        }
+        return (low >> bit_shift) |
+               (static_cast<unsigned __int128>(w2) << (128 - bit_shift));
+    }
+
+    /// @brief 1 つでもビットが立っているかを返す
+    constexpr bool any() const {
+        std::uint64_t acc = 0;
+        for(std::size_t i = 0; i < WORD_SIZE; i++) {
+            acc |= _words[i];
+        }
+        return acc != 0;
+    }
+    constexpr bool none() const { return !any(); }
+
+    /// @brief 立っているビットの数を返す
+    constexpr std::size_t count() const {
+        std::size_t result = 0;
+        for(std::size_t i = 0; i < WORD_SIZE; i++) {
+            result += std::popcount(_words[i]);
+        }
+        return result;
+    }
+
+    /// @brief (*this & other) が空でないかを返す. 一時オブジェクトを作らない
+    constexpr bool intersects(const Bitboard &other) const {
+        std::uint64_t acc = 0;
+        for(std::size_t i = 0; i < WORD_SIZE; i++) {
+            acc |= _words[i] & other._words[i];
+        }
+        return acc != 0;
+    }
+
+    constexpr Bitboard &operator&=(const Bitboard &other) {
+        for(std::size_t i = 0; i < WORD_SIZE; i++) {
+            _words[i] &= other._words[i];
+        }
+        return *this;
+    }
+    constexpr Bitboard &operator|=(const Bitboard &other) {
+        for(std::size_t i = 0; i < WORD_SIZE; i++) {
+            _words[i] |= other._words[i];
+        }
+        return *this;
+    }
+    constexpr Bitboard &operator^=(const Bitboard &other) {
+        for(std::size_t i = 0; i < WORD_SIZE; i++) {
+            _words[i] ^= other._words[i];
+        }
+        return *this;
+    }
+
+    friend constexpr Bitboard operator&(Bitboard lhs, const Bitboard &rhs) {
+        return lhs &= rhs;
+    }
+    friend constexpr Bitboard operator|(Bitboard lhs, const Bitboard &rhs) {
+        return lhs |= rhs;
+    }
+    friend constexpr Bitboard operator^(Bitboard lhs, const Bitboard &rhs) {
+        return lhs ^= rhs;
+    }
+    constexpr Bitboard operator~() const {
+        Bitboard result;
+        for(std::size_t i = 0; i < WORD_SIZE; i++) {
+            result._words[i] = ~_words[i];
+        }
+        result._words[WORD_SIZE - 1] &= LAST_WORD_MASK;
+        return result;
+    }
+    friend constexpr bool operator==(const Bitboard &,
+                                     const Bitboard &) = default;
+
+    /// @brief ビット位置を shift だけ大きい方へずらす. BITS
+    /// からあふれたビットは捨てる
+    constexpr Bitboard operator<<(std::size_t shift) const {
+        Bitboard result;
+        const std::size_t word_shift = shift / 64;
+        const std::size_t bit_shift = shift % 64;
+        for(std::size_t i = WORD_SIZE; i-- > word_shift;) {
+            std::uint64_t value = _words[i - word_shift] << bit_shift;
+            if(bit_shift != 0 and i > word_shift) {
+                value |= _words[i - word_shift - 1] >> (64 - bit_shift);
+            }
+            result._words[i] = value;
+        }
+        result._words[WORD_SIZE - 1] &= LAST_WORD_MASK;
+        return result;
+    }
+
+    /// @brief ビット位置を shift だけ小さい方へずらす
+    constexpr Bitboard operator>>(std::size_t shift) const {
+        Bitboard result;
+        const std::size_t word_shift = shift / 64;
+        const std::size_t bit_shift = shift % 64;
+        for(std::size_t i = 0; i + word_shift < WORD_SIZE; i++) {
+            std::uint64_t value = _words[i + word_shift] >> bit_shift;
+            if(bit_shift != 0 and i + word_shift + 1 < WORD_SIZE) {
+                value |= _words[i + word_shift + 1] << (64 - bit_shift);
+            }
+            result._words[i] = value;
+        }
+        return result;
+    }
+
+    /// @brief 立っているビットの位置を小さい順に f に渡す
+    template <class F>
+    constexpr void for_each(F &&f) const {
+        for(std::size_t i = 0; i < WORD_SIZE; i++) {
+            std::uint64_t word = _words[i];
+            while(word != 0) {
+                f(i * 64 + std::countr_zero(word));
+                word &= word - 1;
+            }
+        }
+    }
+};
@@ -0,0 +1,152 @@
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#pragma once
+#include "move.hpp"
+#include "pieces.hpp"
+#include "players.hpp"
+
+/// @brief 探索の途中経過. Solver の探索スタックをそのまま表す.
+/// - fingerprint: 探索したルールの指紋 (rule_fingerprint)
+/// - root: 探索を始めた局面までの手順 (solve(prefix) の prefix)
+/// - path: root から現在の局面までの手順
+/// - next: next[i] := root から i 手目の局面で, 次に試す合法手の番号
+/// - used: used[p] := プレイヤー p の使用済みブロックの集合 (ビット i
+///   がブロック i). path から復元できるが, 読み込み時の検証に使う
+/// - total_steps, complete_games: その時点までの集計
+/// - output_records, output_offset: その時点で局面のファイルに書き出した
+///   レコードの数と, その終端の位置 (バイト). 局面を書き出さないなら 0.
+///   再開時はファイルをこの位置まで切り詰め, 後に書いた局面を捨てる
+///
+/// 合法手の並びは局面から一意に決まるので保存せず, 再開時に生成し直す.
+struct Checkpoint {
+    static constexpr std::uint32_t MAGIC = 0x434b4c42;  // "BLKC"
+    // 合法手の並び順を変えたら上げる. next の意味が変わるため
+    static constexpr std::uint32_t VERSION = 4;
+
+    std::uint64_t fingerprint = 0;
+    std::vector<Move> root;
+    std::vector<Move> path;
+    std::vector<std::uint32_t> next;
+    std::array<std::uint32_t, PLAYER_SIZE> used{};
+    unsigned long long total_steps = 0;
+    unsigned long long complete_games = 0;
+    std::uint64_t output_records = 0;
+    std::uint64_t output_offset = 0;
+
+    /// @brief file_path に書き出す. 書き込み途中で落ちても前回の
+    /// チェックポイントが残るよう, 一時ファイルに書いてから置き換える
+    void save(const std::string &file_path) const {
+        const std::string temporary_path = file_path + ".tmp";
+        {
+            std::ofstream file(temporary_path, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("Failed to open file: " +
+                                         temporary_path);
+            }
+            write_value(file, MAGIC);
+            write_value(file, VERSION);
+            write_value(file, fingerprint);
+            write_moves(file, root);
+            write_moves(file, path);
+            write_value(file, static_cast<std::uint32_t>(next.size()));
+            for (std::uint32_t index : next) {
+                write_value(file, index);
+            }
+            for (std::uint32_t mask : used) {
+                write_value(file, mask);
+            }
+            write_value(file, static_cast<std::uint64_t>(total_steps));
+            write_value(file, static_cast<std::uint64_t>(complete_games));
+            write_value(file, output_records);
+            write_value(file, output_offset);
+            if (!file) {
+                throw std::runtime_error("Failed to write file: " +
+                                         temporary_path);
+            }
+        }
+        if (std::rename(temporary_path.c_str(), file_path.c_str()) != 0) {
+            throw std::runtime_error("Failed to rename file: " +
+                                     temporary_path);
+        }
+    }
+
+    /// @brief file_path を読む. ルールの指紋が fingerprint と違えば
+    /// (別のルールの探索のものなら) エラーにする
+    static Checkpoint load(const std::string &file_path,
+                           std::uint64_t fingerprint) {
+        std::ifstream file(file_path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open file: " + file_path);
+        }
+        if (read_value<std::uint32_t>(file) != MAGIC or
+            read_value<std::uint32_t>(file) != VERSION) {
+            throw std::runtime_error("Not a checkpoint file: " + file_path);
+        }
+        Checkpoint checkpoint;
+        checkpoint.fingerprint = read_value<std::uint64_t>(file);
+        if (checkpoint.fingerprint != fingerprint) {
+            throw std::runtime_error("Checkpoint for other rules: " +
+                                     file_path);
+        }
+        checkpoint.root = read_moves(file);
+        checkpoint.path = read_moves(file);
+        checkpoint.next.resize(read_value<std::uint32_t>(file));
+        for (std::uint32_t &index : checkpoint.next) {
+            index = read_value<std::uint32_t>(file);
+        }
+        for (std::uint32_t &mask : checkpoint.used) {
+            mask = read_value<std::uint32_t>(file);
+        }
+        checkpoint.total_steps = read_value<std::uint64_t>(file);
+        checkpoint.complete_games = read_value<std::uint64_t>(file);
+        checkpoint.output_records = read_value<std::uint64_t>(file);
+        checkpoint.output_offset = read_value<std::uint64_t>(file);
+        if (!file or checkpoint.next.size() != checkpoint.path.size() + 1) {
+            throw std::runtime_error("Broken checkpoint file: " + file_path);
+        }
+        return checkpoint;
+    }
+
+   private:
+    template <class T>
+    static void write_value(std::ofstream &file, T value) {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template <class T>
+    static T read_value(std::ifstream &file) {
+        T value{};
+        file.read(reinterpret_cast<char *>(&value), sizeof(value));
+        return value;
+    }
+
+    /// @brief 手順を (向き, x, y) の 3 バイトずつで書き出す
+    static void write_moves(std::ofstream &file,
+                            const std::vector<Move> &moves) {
+        write_value(file, static_cast<std::uint32_t>(moves.size()));
+        for (const Move &move : moves) {
+            write_value(file, static_cast<std::uint8_t>(move.orientation));
+            write_value(file, static_cast<std::uint8_t>(move.position.x));
+            write_value(file, static_cast<std::uint8_t>(move.position.y));
+        }
+    }
+
+    static std::vector<Move> read_moves(std::ifstream &file) {
+        std::vector<Move> moves(read_value<std::uint32_t>(file));
+        for (Move &move : moves) {
+            move.orientation = read_value<std::uint8_t>(file);
+            move.position.x = read_value<std::uint8_t>(file);
+            move.position.y = read_value<std::uint8_t>(file);
+            if (move.orientation >= ORIENTATION_SIZE) {
+                throw std::runtime_error("Broken move in checkpoint");
+            }
+        }
+        return moves;
+    }
+};
@@ -0,0 +1,198 @@
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#pragma once
+#include "field.hpp"
+#include "game_state.hpp"
+#include "move.hpp"
+#include "pieces.hpp"
+#include "players.hpp"
+#include "rules.hpp"
+
+/// @brief 終盤の局面で, 各プレイヤーがこれから置きうるマスが互いに重ならなく
+/// なったら, プレイヤーごとに自分の手順だけを数えて部分木の集計を求める.
+///
+/// プレイヤー p がこれから置くマスは, 空いていて p のブロックと辺で接さない
+/// マスのうち, p の角 (まだ置いていなければ開始マス) から 8 近傍でつながる
+/// 範囲 (到達範囲) に収まる. 到達範囲がどの 2 人でも重ならなければ, 他の
+/// プレイヤーの手は p の合法手を変えないので, p の手順は他と関係のない木
+/// (p だけが続けて置く木) になる. 手番の順は固定なので, 全体の局面は
+/// 各プレイヤーの木の節点の組のうち手番の順に矛盾しないものと 1 対 1 に
+/// 対応し, 木の深さごとの節点の数の積の和で数えられる. 手順の並べ方を
+/// 列挙しないので, 探索する節点の数が積から和に減る.
+///
+/// 到達範囲は必要十分ではなく, 重なっていても実際には干渉しない局面は
+/// 分けずに通常どおり探索する. 集計は探索したときと一致する
+template <class Rules, template <class> class FieldType = BasicField>
+class BasicEndgameAnalyzer {
+    using Field = FieldType<Rules>;
+    using Geometry = FieldGeometry<Rules>;
+    using Board = typename Geometry::Board;
+    using GameState = BasicGameState<Rules>;
+    static constexpr std::size_t FIELD_WIDTH = Rules::FIELD_WIDTH;
+    static constexpr unsigned short PLAYER_SIZE = Rules::PLAYER_SIZE;
+    // 1 人のプレイヤーが置くブロックの数の最大値
+    static constexpr unsigned short MAX_DEPTH = rule_block_size<Rules>();
+    static constexpr bool PASSING = rule_passes<Rules>();
+
+    /// @brief 1 人のプレイヤーの木の深さ (置いた数) ごとの節点の数.
+    /// - nodes[k]: 節点の数
+    /// - dead[k]: 合法手の無い節点 (葉) の数
+    /// - complete[k]: ブロックを使い切った節点の数 (葉に含まれる)
+    struct PlayerTree {
+        std::array<unsigned long long, MAX_DEPTH + 1> nodes{};
+        std::array<unsigned long long, MAX_DEPTH + 1> dead{};
+        std::array<unsigned long long, MAX_DEPTH + 1> complete{};
+    };
+
+    // 各プレイヤーの木を数えるときに置いたり戻したりするフィールド
+    Field _field;
+    std::array<PlayerTree, PLAYER_SIZE> _trees{};
+    // _moves[k] := 木の深さ k の節点の合法手
+    std::array<std::vector<Move>, MAX_DEPTH + 1> _moves{};
+
+   public:
+    /// @brief field の局面 (手番のプレイヤーに合法手があること) で, 各
+    /// プレイヤーの到達範囲が互いに重ならなければ, 部分木のノード数と完全な
+    /// ゲームの数を steps と games に入れて true を返す. 重なれば false
+    bool count(const Field &field, unsigned long long &steps,
+               unsigned long long &games) {
+        if (!is_independent(field.state())) {
+            return false;
+        }
+        _field = field;
+        for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            _trees[player] = PlayerTree();
+            count_tree(static_cast<Player>(player), 0, _trees[player]);
+        }
+        combine(field.state().player, steps, games);
+        return true;
+    }
+
+    /// @brief state で, ブロックを置く余地のある各プレイヤーの到達範囲が
+    /// どの 2 人でも重ならないかを返す
+    static bool is_independent(const GameState &state) {
+        Board occupied;
+        for (const Board &board : state.boards) {
+            occupied |= board;
+        }
+        Board reached;
+        for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            if (state.remaining[player] == 0 or
+                ((state.passed >> player) & 1)) {
+                continue;
+            }
+            const Board region = reachable_cells(
+                state.boards[player], occupied, Rules::START_POSITIONS[player]);
+            if (region.intersects(reached)) {
+                return false;
+            }
+            reached |= region;
+        }
+        return true;
+    }
+
+   private:
+    /// @brief board のプレイヤーがこれから置きうるマスの範囲を返す
+    static Board reachable_cells(const Board &board, const Board &occupied,
+                                 const Position &start) {
+        const Board allowed =
+            ~(occupied | Geometry::adjacent_neighbours(board));
+        Board region;
+        if (board.none()) {
+            region.set(start.x * FIELD_WIDTH + start.y);
+        } else {
+            region = Geometry::diagonal_neighbours(board);
+        }
+        region &= allowed;
+        while (true) {
+            const Board grown =
+                region | ((Geometry::adjacent_neighbours(region) |
+                           Geometry::diagonal_neighbours(region)) &
+                          allowed);
+            if (grown == region) {
+                return region;
+            }
+            region = grown;
+        }
+    }
+
+    /// @brief _field で player だけが続けて置く木を数える
+    void count_tree(Player player, unsigned short depth, PlayerTree &tree) {
+        tree.nodes[depth]++;
+        if (_field.state().remaining[player] == 0) {
+            tree.dead[depth]++;
+            tree.complete[depth]++;
+            return;
+        }
+        std::vector<Move> &moves = _moves[depth];
+        _field.generate_moves(player, moves);
+        if (moves.empty()) {
+            tree.dead[depth]++;
+            return;
+        }
+        for (const Move &move : moves) {
+            _field.place(move.position.x, move.position.y, move.orientation,
+                         player);
+            count_tree(player, depth + 1, tree);
+            _field.remove(move.position.x, move.position.y,
+                          move.orientation);
+        }
+    }
+
+    /// @brief 各プレイヤーの木から全体の部分木の集計を求める.
+    /// 手番 first から数えて i 番目のプレイヤー q が j 個目のブロックを
+    /// 置いた局面では, q より前のプレイヤーは j 個置いていて, q より後の
+    /// プレイヤーは j - 1 個置いている. パスするルールでは, それより少ない
+    /// 数で葉に達してパスしたプレイヤーも含める.
+    /// ブロックを置いた局面の数の和がノード数, そのうち全員がブロックを
+    /// 使い切った局面の数が完全なゲームの数になる
+    void combine(unsigned short first, unsigned long long &steps,
+                 unsigned long long &games) const {
+        // before[p][k] := プレイヤー p が k 個置いた時点で取りうる節点の数
+        // (パスするルールでは, k 個より前に葉に達した節点を含む).
+        // complete_before[p][k] も同様で, ブロックを使い切った節点の数
+        std::array<std::array<unsigned long long, MAX_DEPTH + 1>, PLAYER_SIZE>
+            before{}, complete_before{};
+        for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            const PlayerTree &tree = _trees[player];
+            unsigned long long dead = 0, complete = 0;
+            for (unsigned short k = 0; k <= MAX_DEPTH; k++) {
+                before[player][k] = tree.nodes[k];
+                complete_before[player][k] = tree.complete[k];
+                if constexpr (PASSING) {
+                    before[player][k] += dead;
+                    complete_before[player][k] += complete;
+                    dead += tree.dead[k];
+                    complete += tree.complete[k];
+                }
+            }
+        }
+        steps = 0;
+        games = 0;
+        for (unsigned short j = 1; j <= MAX_DEPTH; j++) {
+            for (unsigned short i = 0; i < PLAYER_SIZE; i++) {
+                const unsigned short mover = (first + i) % PLAYER_SIZE;
+                unsigned long long nodes = _trees[mover].nodes[j];
+                unsigned long long complete = _trees[mover].complete[j];
+                if (nodes == 0) {
+                    continue;
+                }
+                for (unsigned short other = 0; other < PLAYER_SIZE; other++) {
+                    if (other == i) {
+                        continue;
+                    }
+                    const unsigned short player = (first + other) % PLAYER_SIZE;
+                    const unsigned short placed = other < i ? j : j - 1;
+                    nodes *= before[player][placed];
+                    complete *= complete_before[player][placed];
+                }
+                steps += nodes;
+                games += complete;
+            }
+        }
+    }
+};
+
+using EndgameAnalyzer = BasicEndgameAnalyzer<ClassicRules>;
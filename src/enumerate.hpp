@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#pragma once
+#include "field.hpp"
+#include "game_state.hpp"
+#include "generator.hpp"
+#include "move.hpp"
+#include "players.hpp"
+#include "rules.hpp"
+
+/// @brief enumerate_positions が返す局面. どれも列挙中の値を参照するので,
+/// 次の局面を取り出すまで有効
+/// - moves: 初手からこの局面までの手順 (root を含む)
+/// - field: 局面のフィールド. 手番のプレイヤーの合法手などを調べられる
+/// - depth: root からの手数 (1 以上)
+/// - is_leaf: 子を展開しない局面 (終局か max_depth 手先) かどうか
+template <class Rules>
+struct EnumeratedPosition {
+    const std::vector<Move> &moves;
+    const BasicField<Rules> &field;
+    unsigned short depth;
+    bool is_leaf;
+
+    const BasicGameState<Rules> &state() const { return field.state(); }
+    const Move &last_move() const { return moves.back(); }
+};
+
+/// @brief enumerate_positions の設定
+/// - max_depth: root から何手先までたどるか. 0 なら終局まで
+/// - leaves_only: 子を展開しない局面だけを返す
+struct EnumerateOptions {
+    unsigned short max_depth = 0;
+    bool leaves_only = false;
+};
+
+/// @brief enumerate_positions で filter を省いたときに, すべての局面を返す
+struct AcceptAllPositions {
+    template <class T>
+    bool operator()(const T &) const {
+        return true;
+    }
+};
+
+/// @brief ルール Rules で root を置いた局面以下の局面を, 探索 (BasicSolver)
+/// と同じ順 (深さ優先, 合法手の順) に 1 つずつ返す. 取り出すたびに
+/// 次の局面まで探索を進めるので, ファイルに書き出さずに同じプロセスで
+/// 調べられ, 途中で break すればそこで探索をやめる.
+/// root の局面自体は返さないので, すべてたどると返す局面の数は
+/// Solver::solve(root) の total_steps と同じになる
+/// @param filter filter(position) が true の局面だけを返す.
+/// false の局面の子もたどる
+template <class Rules = ClassicRules, class Filter = AcceptAllPositions>
+Generator<EnumeratedPosition<Rules>> enumerate_positions(
+    std::vector<Move> root = {}, EnumerateOptions options = {},
+    Filter filter = {}) {
+    using Field = BasicField<Rules>;
+    constexpr bool PASSING = rule_passes<Rules>();
+    Field field;
+    std::vector<Move> path;
+    path.reserve(rule_max_turn<Rules>());
+    for (const Move &move : root) {
+        if constexpr (PASSING) {
+            field.pass_dead_players();
+        }
+        field.place(move.position.x, move.position.y, move.orientation,
+                    static_cast<Player>(field.state().player));
+        path.push_back(move);
+    }
+    const unsigned short root_turn = field.current_turn;
+    unsigned short limit = rule_max_turn<Rules>() - root_turn;
+    if (options.max_depth != 0) {
+        limit = std::min(limit, options.max_depth);
+    }
+    // moves[d] := root から d 手目の局面の合法手, next[d] := 次に試す添字
+    std::vector<std::vector<Move>> moves(limit + 1);
+    std::vector<std::size_t> next(limit + 1, 0);
+
+    // 現在の局面の子を展開するなら合法手を用意して true を返す
+    const auto expand = [&](unsigned short depth) {
+        if (depth == limit or field.state().is_all_blocks_used()) {
+            return false;
+        }
+        if constexpr (PASSING) {
+            if (!field.pass_dead_players()) {
+                return false;
+            }
+        }
+        field.generate_moves(static_cast<Player>(field.state().player),
+                             moves[depth]);
+        next[depth] = 0;
+        return !moves[depth].empty();
+    };
+
+    if (!expand(0)) {
+        co_return;
+    }
+    unsigned short depth = 0;
+    while (true) {
+        if (next[depth] == moves[depth].size()) {
+            if (depth == 0) {
+                co_return;
+            }
+            const Move &move = path.back();
+            field.remove(move.position.x, move.position.y, move.orientation);
+            path.pop_back();
+            depth--;
+            continue;
+        }
+        const Move move = moves[depth][next[depth]++];
+        field.place(move.position.x, move.position.y, move.orientation,
+                    static_cast<Player>(field.state().player));
+        path.push_back(move);
+        depth++;
+        const bool expanded = expand(depth);
+        const EnumeratedPosition<Rules> position{path, field, depth,
+                                                 !expanded};
+        if ((!options.leaves_only or !expanded) and filter(position)) {
+            co_yield position;
+        }
+        if (!expanded) {
+            field.remove(move.position.x, move.position.y, move.orientation);
+            path.pop_back();
+            depth--;
+        }
+    }
+}
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#pragma once
+#include "move.hpp"
+#include "solver.hpp"
+
+// 信頼区間に使う標準正規分布の両側 95% 点
+constexpr double CONFIDENCE_Z = 1.96;
+
+/// @brief Knuth の推定の設定
+/// - probes: 初手から子のない局面までたどる回数の合計
+/// - thread_size: 並列にたどるスレッドの数
+/// - stratify_depth: 0 でなければ, 部分木の根からこの手数までは数え上げ,
+///   その先の局面ごとに層を分けてたどる (層別サンプリング).
+///   各層には少なくとも 2 回ずつ割り当てる
+/// - weighted: マスの多いブロックの手ほど選びやすくする (重点サンプリング)
+/// - seed: 乱数の種. 何回目にたどるかごとに種を決めるので,
+///   スレッドの数によらず同じ推定値になる
+struct EstimateOptions {
+    unsigned long long probes = 1000;
+    unsigned short thread_size = 1;
+    unsigned short stratify_depth = 0;
+    bool weighted = false;
+    std::uint64_t seed = 0;
+};
+
+/// @brief 探索木の大きさの推定値と, 95% 信頼区間の半幅 (*_error).
+/// - nodes[i]: ターン i の局面の数. 部分木の根より浅いターンは 0
+/// - total_steps: ブロックを置く回数 (Solver::stats と同じ数え方)
+/// - complete_games: 全プレイヤーがすべてのブロックを使い切った局面の数
+struct TreeEstimate {
+    std::array<double, MAX_TURN + 1> nodes{}, nodes_error{};
+    double total_steps = 0, total_steps_error = 0;
+    double complete_games = 0, complete_games_error = 0;
+    unsigned long long probes = 0;
+};
+
+/// @brief ルール Rules で roots のそれぞれを置いた局面以下の部分木を合わせた
+/// 大きさを, Knuth の推定で求める. 根の手自体は数えない
+/// (Solver::solve(prefix) と同じ)
+template <class Rules>
+class BasicTreeEstimator {
+    using Solver = BasicSolver<Rules>;
+
+    /// @brief 1 つの層でたどった結果の和と 2 乗和
+    struct StratumSums {
+        unsigned long long probes = 0;
+        std::array<double, MAX_TURN + 1> nodes{}, nodes_square{};
+        double total = 0, total_square = 0;
+        double games = 0, games_square = 0;
+
+        StratumSums &operator+=(const StratumSums &other) {
+            probes += other.probes;
+            for (unsigned short turn = 0; turn <= MAX_TURN; turn++) {
+                nodes[turn] += other.nodes[turn];
+                nodes_square[turn] += other.nodes_square[turn];
+            }
+            total += other.total;
+            total_square += other.total_square;
+            games += other.games;
+            games_square += other.games_square;
+            return *this;
+        }
+    };
+
+    /// @brief 層ごとの平均の和と, 層ごとの平均の分散の和.
+    /// 層の平均の和が推定値, 分散の和がその分散になる
+    struct EstimateSums {
+        std::array<double, MAX_TURN + 1> nodes{}, nodes_variance{};
+        double total = 0, total_variance = 0;
+        double games = 0, games_variance = 0;
+
+        /// @brief たどり終えた 1 つの層の結果を足す
+        void add(const StratumSums &stratum) {
+            for (unsigned short turn = 0; turn <= MAX_TURN; turn++) {
+                nodes[turn] += mean(stratum.nodes[turn], stratum.probes);
+                nodes_variance[turn] +=
+                    mean_variance(stratum.nodes[turn],
+                                  stratum.nodes_square[turn], stratum.probes);
+            }
+            total += mean(stratum.total, stratum.probes);
+            total_variance += mean_variance(stratum.total,
+                                            stratum.total_square,
+                                            stratum.probes);
+            games += mean(stratum.games, stratum.probes);
+            games_variance += mean_variance(stratum.games,
+                                            stratum.games_square,
+                                            stratum.probes);
+        }
+    };
+
+    /// @brief スレッドの間で共有する, たどる順番と途中の層の和.
+    /// たどる回数 i (層 i % 層の数) を層の順に並べ, 先頭から
+    /// BATCH_SIZE 回ずつスレッドに配る. 層の和はたどり終えたものから
+    /// sums に足して捨てるので, 残るのはスレッドがたどっている途中の
+    /// 層だけになり, 層の数によらない大きさで済む
+    struct ProbeSchedule {
+        static constexpr unsigned long long BATCH_SIZE = 16;
+
+        unsigned long long probes;
+        std::size_t stratum_size;
+        std::atomic<unsigned long long> next{0};
+        std::mutex mutex;
+        std::unordered_map<std::size_t, StratumSums> open;
+        EstimateSums sums;
+
+        ProbeSchedule(unsigned long long probes, std::size_t stratum_size)
+            : probes(probes), stratum_size(stratum_size) {}
+
+        /// @brief 層 stratum でたどる回数
+        unsigned long long stratum_probes(std::size_t stratum) const {
+            return probes / stratum_size + (stratum < probes % stratum_size);
+        }
+
+        /// @brief 層の順に並べた k 番目について, 層と, たどる回数 i を返す
+        std::size_t locate(unsigned long long k,
+                           unsigned long long &index) const {
+            const unsigned long long quotient = probes / stratum_size;
+            const unsigned long long remainder = probes % stratum_size;
+            std::size_t stratum;
+            unsigned long long order;
+            if (k < remainder * (quotient + 1)) {
+                stratum = k / (quotient + 1);
+                order = k % (quotient + 1);
+            } else {
+                k -= remainder * (quotient + 1);
+                stratum = remainder + k / quotient;
+                order = k % quotient;
+            }
+            index = stratum + order * stratum_size;
+            return stratum;
+        }
+
+        /// @brief 層 stratum の一部の和 part を足し, その層をたどり終えたら
+        /// sums に足す
+        void merge(std::size_t stratum, const StratumSums &part) {
+            std::lock_guard<std::mutex> lock(mutex);
+            StratumSums &total = open[stratum];
+            total += part;
+            if (total.probes == stratum_probes(stratum)) {
+                sums.add(total);
+                open.erase(stratum);
+            }
+        }
+    };
+
+    EstimateOptions _options;
+
+   public:
+    explicit BasicTreeEstimator(const EstimateOptions &options)
+        : _options(options) {}
+
+    TreeEstimate estimate(const std::vector<std::vector<Move>> &roots) const {
+        TreeEstimate result;
+        // 層の根. stratify_depth 手目までは数え上げて result に足す
+        std::vector<std::vector<Move>> strata;
+        for (const std::vector<Move> &root : roots) {
+            if (_options.stratify_depth == 0) {
+                strata.push_back(root);
+                continue;
+            }
+            Solver counter;
+            const std::vector<unsigned long long> counts =
+                counter.count(root, _options.stratify_depth);
+            for (std::size_t depth = 1; depth < counts.size(); depth++) {
+                result.nodes[root.size() + depth] += counts[depth];
+                result.total_steps += counts[depth];
+            }
+            Solver splitter;
+            splitter.set_save_positions(false);
+            splitter.split(root, _options.stratify_depth, strata);
+            result.complete_games += splitter.stats().complete_games;
+        }
+        if (strata.empty()) {
+            return result;
+        }
+
+        // たどる回数 i を層 i % strata.size() に割り当てる
+        const unsigned long long probes =
+            std::max<unsigned long long>(_options.probes, 2 * strata.size());
+        const unsigned short thread_size =
+            std::max<unsigned short>(_options.thread_size, 1);
+        ProbeSchedule schedule(probes, strata.size());
+        std::vector<std::thread> workers;
+        for (unsigned short worker = 0; worker < thread_size; worker++) {
+            workers.emplace_back(
+                [this, &strata, &schedule] { work(strata, schedule); });
+        }
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+
+        const EstimateSums &sums = schedule.sums;
+        for (unsigned short turn = 0; turn <= MAX_TURN; turn++) {
+            result.nodes[turn] += sums.nodes[turn];
+            result.nodes_error[turn] =
+                CONFIDENCE_Z * std::sqrt(sums.nodes_variance[turn]);
+        }
+        result.total_steps += sums.total;
+        result.total_steps_error = CONFIDENCE_Z * std::sqrt(sums.total_variance);
+        result.complete_games += sums.games;
+        result.complete_games_error =
+            CONFIDENCE_Z * std::sqrt(sums.games_variance);
+        result.probes = probes;
+        return result;
+    }
+
+   private:
+    /// @brief 1 つのスレッドの処理. schedule から BATCH_SIZE 回ずつ取り,
+    /// たどる回数から決めた種で 1 回ずつたどって層ごとに足す.
+    /// 層が変わるときと配られた分の終わりに, 足した分を schedule に渡す
+    void work(const std::vector<std::vector<Move>> &strata,
+              ProbeSchedule &schedule) const {
+        Solver solver;
+        std::vector<double> estimates(MAX_TURN + 1);
+        std::mt19937_64 random;
+        while (true) {
+            const unsigned long long begin =
+                schedule.next.fetch_add(ProbeSchedule::BATCH_SIZE);
+            if (begin >= schedule.probes) {
+                break;
+            }
+            const unsigned long long end = std::min(
+                begin + ProbeSchedule::BATCH_SIZE, schedule.probes);
+            StratumSums part;
+            std::size_t part_stratum = 0;
+            for (unsigned long long k = begin; k < end; k++) {
+                unsigned long long index;
+                const std::size_t stratum = schedule.locate(k, index);
+                if (part.probes != 0 and stratum != part_stratum) {
+                    schedule.merge(part_stratum, part);
+                    part = StratumSums();
+                }
+                part_stratum = stratum;
+                random.seed(_options.seed ^ (index * 0x9e3779b97f4a7c15ULL));
+                std::fill(estimates.begin(), estimates.end(), 0.0);
+                const double games = solver.probe(strata[stratum], random,
+                                                  _options.weighted, estimates);
+                double total = 0;
+                for (unsigned short turn = 0; turn <= MAX_TURN; turn++) {
+                    part.nodes[turn] += estimates[turn];
+                    part.nodes_square[turn] +=
+                        estimates[turn] * estimates[turn];
+                    total += estimates[turn];
+                }
+                part.probes++;
+                part.total += total;
+                part.total_square += total * total;
+                part.games += games;
+                part.games_square += games * games;
+            }
+            schedule.merge(part_stratum, part);
+        }
+    }
+
+    static double mean(double sum, unsigned long long count) {
+        return count == 0 ? 0 : sum / count;
+    }
+
+    /// @brief 和と 2 乗和から, 標本平均の分散 (不偏分散 / count) を求める
+    static double mean_variance(double sum, double square,
+                                unsigned long long count) {
+        if (count < 2) {
+            return 0;
+        }
+        const double average = sum / count;
+        return std::max(0.0, (square - sum * average) / (count - 1)) / count;
+    }
+};
+
+using TreeEstimator = BasicTreeEstimator<ClassicRules>;
@@ -1,23 +1,141 @@
+#include <algorithm>
 #include <array>
-#include <bitset>
 #include <cassert>
+#include <concepts>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #pragma once
-#include "blocks.hpp"
-#include "directions.hpp"
+#include "anchor_kernel.hpp"
+#include "bitboard.hpp"
+#include "game_state.hpp"
+#include "move.hpp"
+#include "pieces.hpp"
 #include "players.hpp"
+#include "position.hpp"
+#include "rules.hpp"
+#include "telemetry.hpp"
+#include "zobrist.hpp"
 
-// 上下左右の 4 近傍
-constexpr short adjacent_neighbouring_dx[] = {-1, 1, 0, 0};
-constexpr short adjacent_neighbouring_dy[] = {0, 0, -1, 1};
-// 斜めの 4 近傍
-constexpr short diagonal_neighbouring_dx[] = {-1, -1, 1, 1};
-constexpr short diagonal_neighbouring_dy[] = {-1, 1, -1, 1};
+/// @brief ルール Rules のフィールドの大きさで決まる表. どれもコンパイル時に作る.
+/// マス (x, y) を x * FIELD_WIDTH + y 番目のビットに対応させ,
+/// ビットボードはフィールドが収まる最小の語数にする
+template <class Rules>
+struct FieldGeometry {
+    // フィールドの縦横の長さ
+    static constexpr std::size_t FIELD_WIDTH = Rules::FIELD_WIDTH;
+    // フィールドのマスの数
+    static constexpr std::size_t FIELD_CELL_SIZE = FIELD_WIDTH * FIELD_WIDTH;
+    // 左上のマスの集合の語数. AVX2 のレジスタの本数分に切り上げる
+    static constexpr std::size_t ANCHOR_WORD_SIZE =
+        anchor_word_size((FIELD_CELL_SIZE + 63) / 64);
 
-// フィールドの縦横の長さ
-constexpr std::size_t FIELD_WIDTH = 20;
+    static_assert(FIELD_WIDTH >= MAX_BLOCK_CELL_SIZE);
+    // PieceMask::window にブロックが収まる
+    static_assert((MAX_BLOCK_CELL_SIZE - 1) * FIELD_WIDTH +
+                      MAX_BLOCK_CELL_SIZE <= 128);
+    static_assert(Rules::PLAYER_SIZE >= 1 and
+                  Rules::PLAYER_SIZE <= PLAYER_SIZE);
+
+    /// @brief フィールド全体のビットボード
+    using Board = Bitboard<FIELD_CELL_SIZE>;
+
+    /// @brief 指定した列のマスすべてに 1 が立ったビットボードを返す
+    static constexpr Board column_mask(std::size_t y) {
+        Board mask;
+        for(std::size_t x = 0; x < FIELD_WIDTH; x++) {
+            mask.set(x * FIELD_WIDTH + y);
+        }
+        return mask;
+    }
+
+    // 左端 (y == 0) 以外のマス. 右にずらしたとき前の行から回り込んだビットを消す
+    static constexpr Board NOT_LEFT_EDGE = ~column_mask(0);
+    // 右端 (y == FIELD_WIDTH - 1) 以外のマス
+    static constexpr Board NOT_RIGHT_EDGE = ~column_mask(FIELD_WIDTH - 1);
+
+    /// @brief board の各マスの上下左右の 4 近傍を集めたビットボードを返す
+    static constexpr Board adjacent_neighbours(const Board &board) {
+        return (board << FIELD_WIDTH) | (board >> FIELD_WIDTH) |
+               ((board << 1) & NOT_LEFT_EDGE) | ((board >> 1) & NOT_RIGHT_EDGE);
+    }
+
+    /// @brief board の各マスの斜めの 4 近傍を集めたビットボードを返す
+    static constexpr Board diagonal_neighbours(const Board &board) {
+        return ((board << (FIELD_WIDTH + 1)) & NOT_LEFT_EDGE) |
+               ((board << (FIELD_WIDTH - 1)) & NOT_RIGHT_EDGE) |
+               ((board >> (FIELD_WIDTH - 1)) & NOT_LEFT_EDGE) |
+               ((board >> (FIELD_WIDTH + 1)) & NOT_RIGHT_EDGE);
+    }
+
+    /// @brief 向き ORIENTATIONS[i] のブロックのビットボード.
+    /// mask はバウンディングボックスの左上をマス (0, 0) に置いたときのもので,
+    /// window は mask の先頭 128 ビット. 高さ 5 以下のブロックはすべて
+    /// window に収まる. shifts[j] は j 番目のマスのバウンディングボックス内の位置
+    /// x * MAX_BLOCK_CELL_SIZE + y, fits は左上に置いてもフィールドから
+    /// はみ出ないマスで, AnchorShifts::scan に渡す.
+    struct PieceMask {
+        Board mask;
+        unsigned __int128 window = 0;
+        std::array<unsigned char, MAX_BLOCK_CELL_SIZE> shifts{};
+        AnchorWords<ANCHOR_WORD_SIZE> fits{};
+    };
+
+    // 各向きのブロックのビットボード. 添字は ORIENTATIONS と共通
+    static constexpr std::array<PieceMask, ORIENTATION_SIZE> PIECE_MASKS = [] {
+        std::array<PieceMask, ORIENTATION_SIZE> piece_masks{};
+        for(std::size_t i = 0; i < ORIENTATION_SIZE; i++) {
+            for(unsigned short j = 0; j < ORIENTATIONS[i].cell_size; j++) {
+                const Position &cell = ORIENTATIONS[i].cells[j];
+                piece_masks[i].mask.set(cell.x * FIELD_WIDTH + cell.y);
+                piece_masks[i].shifts[j] =
+                    cell.x * MAX_BLOCK_CELL_SIZE + cell.y;
+            }
+            piece_masks[i].window = piece_masks[i].mask.window(0);
+            Board fits;
+            for(std::size_t x = 0; x + ORIENTATIONS[i].height <= FIELD_WIDTH;
+                x++) {
+                for(std::size_t y = 0; y + ORIENTATIONS[i].width <= FIELD_WIDTH;
+                    y++) {
+                    fits.set(x * FIELD_WIDTH + y);
+                }
+            }
+            for(std::size_t j = 0; j < Board::WORD_SIZE; j++) {
+                piece_masks[i].fits[j] = fits.word(j);
+            }
+        }
+        return piece_masks;
+    }();
+
+    // ANCHOR_COLUMNS[y] := 列が FIELD_WIDTH - y 未満のマス (AnchorColumns)
+    static constexpr AnchorColumns<ANCHOR_WORD_SIZE> ANCHOR_COLUMNS = [] {
+        AnchorColumns<ANCHOR_WORD_SIZE> columns{};
+        for(std::size_t y = 0; y < MAX_BLOCK_CELL_SIZE; y++) {
+            Board inside;
+            for(std::size_t column = 0; column + y < FIELD_WIDTH; column++) {
+                inside |= column_mask(column);
+            }
+            for(std::size_t j = 0; j < Board::WORD_SIZE; j++) {
+                columns[y][j] = inside.word(j);
+            }
+        }
+        return columns;
+    }();
+
+    // 局面のハッシュに使う乱数表
+    static constexpr ZobristKeys<FIELD_CELL_SIZE> ZOBRIST_KEYS{};
+};
+
+// 通常のブロックスのフィールドの縦横の長さとマスの数.
+// 手順をファイルに書き出すときのマスの番号もこの長さで付ける
+constexpr std::size_t FIELD_WIDTH = ClassicRules::FIELD_WIDTH;
+constexpr std::size_t FIELD_CELL_SIZE = FIELD_WIDTH * FIELD_WIDTH;
+// 通常のブロックスの各プレイヤーの開始マス
+constexpr const auto &START_POSITIONS = ClassicRules::START_POSITIONS;
 
 /// @brief 盤面を表すクラス. 符号なし 8 bit 整数で, 上位 6 bit はターン数
 /// (1-indexed), 下位 2 bit はプレイヤー (00 ~ 11) を表す
@@ -26,205 +144,415 @@ constexpr std::size_t FIELD_WIDTH = 20;
 /// であれば, そのマスにはどのブロックも置かれていないことを表す. マスの値が
 /// 0000_1001 であれば, そのマスはプレイヤー 1 が 2
 /// 手目に置いたブロックによって使われていることを表す.
-class Field {
+///
+/// 配置判定は _field ではなく, 以下のビットボードに対する AND / OR で行う.
+/// - _occupied: いずれかのプレイヤーのブロックが置かれているマス
+/// - _state.boards[p]: プレイヤー p のブロックが置かれているマス
+/// - _forbidden[p]: プレイヤー p のブロックと上下左右で接するマス
+/// - _corners[p]: プレイヤー p のブロックと斜めに接し, かつ _forbidden[p]
+///   に含まれないマス. まだブロックを置いていなければ START_POSITIONS[p]
+///
+/// 合法手は generate_moves のたびに, 手番のプレイヤーについてすべての左上の
+/// マスをまとめて調べて求める (AnchorShifts). place と remove はビットボードを
+/// 更新するだけで済む.
+///
+/// ブロックの位置はバウンディングボックスの左上のマス (x, y) で指定する.
+/// フィールドの大きさ, プレイヤーの数, 開始マス, 使うブロックは Rules
+/// (rules.hpp) で決まる. 使わないブロックは最初から使用済みにしておく.
+template <class Rules>
+class BasicField {
+  public:
+    using Geometry = FieldGeometry<Rules>;
+    using FieldBoard = typename Geometry::Board;
+    using GameState = BasicGameState<Rules>;
+    static constexpr std::size_t FIELD_WIDTH = Geometry::FIELD_WIDTH;
+    static constexpr std::size_t FIELD_CELL_SIZE = Geometry::FIELD_CELL_SIZE;
+    static constexpr unsigned short PLAYER_SIZE = Rules::PLAYER_SIZE;
+    static constexpr const auto &START_POSITIONS = Rules::START_POSITIONS;
+    // 局面から再現したブロックのマスに書くターン. 手順は分からないので,
+    // どの手のターンとも重ならない値にして 0 (空き) と区別する
+    static constexpr unsigned short UNKNOWN_TURN = rule_max_turn<Rules>() + 1;
+
+  private:
+    // このフィールドの語数で具体化した表と型
+    static constexpr std::size_t ANCHOR_WORD_SIZE = Geometry::ANCHOR_WORD_SIZE;
+    using AnchorWords = ::AnchorWords<ANCHOR_WORD_SIZE>;
+    using AnchorBoard = ::AnchorBoard<ANCHOR_WORD_SIZE>;
+    using AnchorScan = ::AnchorScan<ANCHOR_WORD_SIZE>;
+    using AnchorShifts = ::AnchorShifts<ANCHOR_WORD_SIZE>;
+    using PieceMask = typename Geometry::PieceMask;
+    static constexpr const auto &PIECE_MASKS = Geometry::PIECE_MASKS;
+    static constexpr const auto &ZOBRIST_KEYS = Geometry::ZOBRIST_KEYS;
+
     std::array<std::array<short, FIELD_WIDTH>, FIELD_WIDTH> _field{};
+    FieldBoard _occupied;
+    std::array<FieldBoard, PLAYER_SIZE> _forbidden{};
+    std::array<FieldBoard, PLAYER_SIZE> _corners{};
+    // 盤面と使用済みブロックの Zobrist ハッシュ. place / remove で更新する
+    std::uint64_t _hash = 0;
+    // 各プレイヤーの盤面, 残りのブロック, 手番. place / remove で更新する
+    GameState _state = GameState::initial();
+    // _passed_marks[t] := t + 1 手目を置く直前の _state.passed.
+    // パスは手を置いた後に起きるので, remove でその手の前の値に戻せば取り消せる.
+    // パスするルール (rule_passes) のときだけ積む
+    std::vector<std::uint8_t> _passed_marks;
 
-    bool is_in_field(const unsigned short x, const unsigned short y) {
-        return 0 <= x and x < FIELD_WIDTH and 0 <= y and y < FIELD_WIDTH;
+    bool is_in_field(const unsigned short x, const unsigned short y) const {
+        return x < FIELD_WIDTH and y < FIELD_WIDTH;
     }
 
-    /// @brief 上下左右の 4 近傍に自分のブロックがあるかを返す
-    bool has_my_block_in_adjacent_neighbouring_position(const short x,
-                                                        const short y,
-                                                        const Player &player) {
-        for(unsigned short i = 0; i < 4; i++) {
-            short nx = x + adjacent_neighbouring_dx[i];
-            short ny = y + adjacent_neighbouring_dy[i];
-            if(!is_in_field(nx, ny)) {
-                continue;
-            }
-            // 上下左右の隣接マスに自分が置いていたら true を返す
-            if(_field[nx][ny] != 0 and (_field[nx][ny] & 0b11) == player) {
-                return true;
-            }
+    /// @brief (x, y) を左上としたとき, 向き orientation
+    /// のブロックがフィールド内に収まるかを返す
+    bool fits_in_field(const unsigned short x, const unsigned short y,
+                       const unsigned short orientation) const {
+        return x + ORIENTATIONS[orientation].height <= FIELD_WIDTH and
+               y + ORIENTATIONS[orientation].width <= FIELD_WIDTH;
+    }
+
+    /// @brief (x, y) を左上としたときにブロックが占めるマスを返す.
+    /// fits_in_field(x, y, orientation) であること
+    FieldBoard mask_at(const unsigned short x, const unsigned short y,
+                       const unsigned short orientation) const {
+        return PIECE_MASKS[orientation].mask << (x * FIELD_WIDTH + y);
+    }
+
+    /// @brief (x, y) を左上とするブロックの分だけ _hash を XOR で更新する.
+    /// 置くときと取り除くときで同じ処理になる
+    void update_hash(const unsigned short x, const unsigned short y,
+                     const unsigned short orientation, const Player &player) {
+        const Orientation &block = ORIENTATIONS[orientation];
+        for(unsigned short i = 0; i < block.cell_size; i++) {
+            _hash ^= ZOBRIST_KEYS.cells[player][(x + block.cells[i].x) *
+                                                    FIELD_WIDTH +
+                                                y + block.cells[i].y];
         }
-        return false;
+        _hash ^= ZOBRIST_KEYS.blocks[player][block.block];
+    }
+
+    /// @brief プレイヤー player の _forbidden と _corners
+    /// を盤面から計算し直す
+    void update_masks(const Player &player) {
+        if(_state.boards[player].none()) {
+            _forbidden[player] = FieldBoard();
+            _corners[player] = FieldBoard();
+            const Position &start = START_POSITIONS[player];
+            _corners[player].set(start.x * FIELD_WIDTH + start.y);
+            return;
+        }
+        _forbidden[player] =
+            Geometry::adjacent_neighbours(_state.boards[player]);
+        _corners[player] =
+            Geometry::diagonal_neighbours(_state.boards[player]) &
+            ~_forbidden[player];
     }
 
-    /// @brief 斜めの 4 近傍に自分のブロックがあるかを返す
-    bool has_my_block_in_diagonal_neighbouring_position(const short x,
-                                                        const short y,
-                                                        const Player &player) {
-        for(unsigned short i = 0; i < 4; i++) {
-            short nx = x + diagonal_neighbouring_dx[i];
-            short ny = y + diagonal_neighbouring_dy[i];
-            if(!is_in_field(nx, ny)) {
+    /// @brief player の使っていない向きごとに, 置ける左上のマスを盤面から
+    /// まとめて求め, f(向き, AnchorScan) に渡す. f が false を返せば打ち切る
+    template <class F>
+    void scan_legal(const Player &player, F &&f) const {
+        const AnchorShifts shifts(AnchorBoard(_occupied | _forbidden[player]),
+                                  AnchorBoard(_occupied),
+                                  AnchorBoard(live_corners(player)),
+                                  FIELD_WIDTH, Geometry::ANCHOR_COLUMNS);
+        AnchorScan scan;
+        for(unsigned short orientation = 0; orientation < ORIENTATION_SIZE;
+            orientation++) {
+            if(_state.is_used(player, ORIENTATIONS[orientation].block)) {
                 continue;
             }
-            // 斜めの隣接マスの少なくとも 1 つに自分が置いていればよい
-            if(_field[nx][ny] != 0 and (_field[nx][ny] & 0b11) == player) {
-                return true;
+            const PieceMask &piece = PIECE_MASKS[orientation];
+            shifts.scan(piece.fits, piece.shifts.data(),
+                        ORIENTATIONS[orientation].cell_size, scan);
+            if(!f(orientation, scan)) {
+                return;
             }
         }
-        return false;
     }
 
   public:
     unsigned short current_turn = 0;
-    Field() {}
+    BasicField() : BasicField(GameState::initial()) {}
+
+    /// @brief 局面 state を再現する. state までの手順は分からないので,
+    /// 置かれているマスの値はターンを UNKNOWN_TURN とし,
+    /// そのブロックは remove できない
+    explicit BasicField(const GameState &state)
+        : _state(state), current_turn(state.turn) {
+        for(unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            _occupied |= state.boards[player];
+            for(std::size_t x = 0; x < FIELD_WIDTH; x++) {
+                for(std::size_t y = 0; y < FIELD_WIDTH; y++) {
+                    const std::size_t index = x * FIELD_WIDTH + y;
+                    if(state.boards[player].test(index)) {
+                        _field[x][y] = (UNKNOWN_TURN << 2) | player;
+                        _hash ^= ZOBRIST_KEYS.cells[player][index];
+                    }
+                }
+            }
+            for(unsigned short block = 0; block < BLOCK_SIZE; block++) {
+                if(state.is_used(static_cast<Player>(player), block) and
+                   ((Rules::BLOCKS >> block) & 1)) {
+                    _hash ^= ZOBRIST_KEYS.blocks[player][block];
+                }
+            }
+        }
+        for(unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            update_masks(static_cast<Player>(player));
+        }
+    }
+
+    /// @brief 現在の局面. コピーして BasicField(state) に渡せば再現できる
+    const GameState &state() const { return _state; }
 
-    /// @brief 座標 (x, y) にブロックを配置可能か判断する.
-    /// ブロックを置きたいマスがすべて 0 かどうかをチェックする
+    /// @brief 座標 (x, y) を左上としてブロックを配置可能か判断する.
+    /// 置けなかった理由は数えない (RejectReason は合法手の生成で数える)
     /// @param x x 座標
     /// @param y y 座標
-    /// @param block 使用するブロック
-    bool is_able_to_place(short x, short y, const Block &block,
-                          const Player &player) {
+    /// @param orientation 使用するブロックの向き (ORIENTATIONS の添字)
+    bool is_able_to_place(unsigned short x, unsigned short y,
+                          unsigned short orientation,
+                          const Player &player) const {
+        TELEMETRY_TIMER(TIMER_IS_ABLE_TO_PLACE);
         assert(is_in_field(x, y));
 
         // 1. 上下左右の 4 近傍に自分が置いたブロックが 1 つでもあれば NG
         // 2.
         // ブロックを構成する各マスについて、そのいずれもが斜めに自分のブロックと接していなければ
-        // NG
+        // NG (初手では START_POSITIONS[player] を覆っていなければ NG)
         // 3. 置きたいマスが他のブロックにすでに占有されていれば NG
 
-        // 各プレイヤー 1 ターン目であれば、四隅以外は false を返す
-        // 3...0
-        // .....
-        // .....
-        // .....
-        // 2...1
-        if(current_turn == 0) {
-            if(!(x == 0 and y == FIELD_WIDTH - 1)) {
-                return false;
-            }
-        } else if(current_turn == 1) {
-            if(!(x == FIELD_WIDTH - 1 and y == FIELD_WIDTH - 1)) {
-                return false;
-            }
-        } else if(current_turn == 2) {
-            if(!(x == FIELD_WIDTH - 1 and y == 0)) {
-                return false;
-            }
-        } else if(current_turn == 3) {
-            if(!(x == 0 and y == 0)) {
-                return false;
-            }
+        // フィールド外にはみ出ていたら false を返す
+        if(!fits_in_field(x, y, orientation)) {
+            return false;
         }
+        // 左上のビット位置から 128 ビットを切り出し, ブロックのマスクと比較する
+        const std::size_t index = x * FIELD_WIDTH + y;
+        const unsigned __int128 window = PIECE_MASKS[orientation].window;
 
-        // ブロックを配置できるか (ブロックを配置したいマスがすべて 0000_0000
-        // か) をチェック
-        unsigned short field_value = _field[x][y];
+        // 置きたいマスが占有されているか, 自分のブロックと上下左右で接していれば
+        // false を返す
+        if(((_occupied.window(index) | _forbidden[player].window(index)) &
+            window) != 0) {
+            return false;
+        }
+        return (_corners[player].window(index) & window) != 0;
+    }
 
-        // 上下左右の 4 近傍に自分が置いたブロックがないかチェック
-        bool has_my_block_in_adjacent_position =
-            has_my_block_in_adjacent_neighbouring_position(x, y, player);
+    /// @brief 局面 (各プレイヤーの盤面, 使用済みブロック, 手番) のハッシュを返す
+    std::uint64_t hash() const {
+        return _hash ^ ZOBRIST_KEYS.turns[_state.player];
+    }
 
-        // ブロックを構成する各マスについて、そのいずれかが斜めに自分のブロックと接しているかをチェック
-        // current_turn が 0, 1, 2, 3 のときは、各プレイヤー初手なので特別に true とする
-        bool has_my_block_in_diagonal_position =
-            has_my_block_in_diagonal_neighbouring_position(x, y, player) ||
-            current_turn <= 3;
+    /// @brief プレイヤー player がまだ使える角のマス
+    /// (斜めに自分のブロックと接し, 空いているマス) を返す
+    FieldBoard live_corners(const Player &player) const {
+        return _corners[player] & ~_occupied;
+    }
 
-        for(const Direction &direction : block) {
-            x += direction.dx;
-            y += direction.dy;
-            // フィールド外からはみ出ていたら false を返す
-            if(!is_in_field(x, y)) {
-                return false;
+    /// @brief プレイヤー player に合法手があるかどうかを返す.
+    /// パス済み, 残りのブロックが無い, 使える角が無いのいずれかなら
+    /// 調べずに false を返し, それ以外は最初の合法手で打ち切る
+    bool can_move(const Player &player) const {
+        if(((_state.passed >> player) & 1) or _state.remaining[player] == 0) {
+            return false;
+        }
+        if(live_corners(player).none()) {
+            return false;
+        }
+        bool found = false;
+        const auto has_anchor = [&found](const AnchorWords &anchors) {
+            for(const std::uint64_t word : anchors) {
+                found = found or word != 0;
             }
-            // 「今まで通ってきたマスの値」と OR を取る
-            field_value |= _field[x][y];
-            // 「今まで通ってきたマスが、斜めに自分のブロックと接していたかどうか」と
-            // OR を取る
-            has_my_block_in_diagonal_position |=
-                has_my_block_in_diagonal_neighbouring_position(x, y, player);
-            // 「今まで通ってきたマスの中に、自分のマスと接しているものがあるかどうか」と
-            // OR を取る
-            has_my_block_in_adjacent_position |=
-                has_my_block_in_adjacent_neighbouring_position(x, y, player);
+            return !found;
+        };
+        scan_legal(player, [&](unsigned short, const AnchorScan &scan) {
+            return has_anchor(scan.legal);
+        });
+        return found;
+    }
+
+    /// @brief 手番のプレイヤーから順に, 合法手の無いプレイヤーをパスさせて
+    /// 手番を次に回す. 自分のブロックを置かない限り角は増えないので,
+    /// 一度パスしたプレイヤーは二度と置けない. _state.passed に加えて,
+    /// 以降の手番では調べずに飛ばす. パスするルール (rule_passes) なら,
+    /// パスは直前の手の remove で取り消される
+    /// @return 合法手のあるプレイヤーがいれば true (手番はそのプレイヤー),
+    /// 全員がパスしていれば false (終局)
+    bool pass_dead_players() {
+        for(unsigned short i = 0; i < PLAYER_SIZE; i++) {
+            const Player player = static_cast<Player>(_state.player);
+            if(can_move(player)) {
+                return true;
+            }
+            _state.passed |= 1u << player;
+            _state.player = (player + 1) % PLAYER_SIZE;
+        }
+        return false;
+    }
+
+    /// @brief プレイヤー player の合法手をすべて moves に格納する.
+    /// 合法手は向き, 左上のマスの順に並ぶ. 使用済みのブロックは除く.
+    /// 置けなかった左上のマスの理由 (RejectReason) を telemetry_counters
+    /// に数える
+    void generate_moves(const Player &player, std::vector<Move> &moves) const {
+        TELEMETRY_TIMER(TIMER_GENERATE_MOVES);
+        moves.clear();
+        const auto add_moves = [&](const unsigned short orientation,
+                                   const AnchorWords &anchors) {
+            for_each_anchor(anchors, [&](const std::size_t index) {
+                moves.emplace_back(orientation,
+                                   Position(index / FIELD_WIDTH,
+                                            index % FIELD_WIDTH));
+            });
+        };
+        if(live_corners(player).none()) {
+            return;
         }
+        scan_legal(player, [&](const unsigned short orientation,
+                               const AnchorScan &scan) {
+            add_moves(orientation, scan.legal);
+            telemetry_counters.reject(REJECT_OUT_OF_FIELD, scan.out_of_field);
+            telemetry_counters.reject(REJECT_OCCUPIED, scan.occupied);
+            telemetry_counters.reject(REJECT_EDGE_ADJACENT, scan.edge_adjacent);
+            telemetry_counters.reject(REJECT_NO_DIAGONAL_CONTACT,
+                                      scan.no_diagonal_contact);
+            return true;
+        });
+    }
 
-        return (field_value == 0) && has_my_block_in_diagonal_position && !has_my_block_in_adjacent_position;
+    /// @brief プレイヤー player の合法手の数を返す. 合法手は作らない
+    std::size_t count_moves(const Player &player) const {
+        std::size_t result = 0;
+        if(live_corners(player).any()) {
+            scan_legal(player, [&](unsigned short, const AnchorScan &scan) {
+                result += count_anchors(scan.legal);
+                return true;
+            });
+        }
+        return result;
     }
 
-    /// @brief 座標 (x, y) にブロックを置く
+    /// @brief 座標 (x, y) を左上としてブロックを置く
     /// @param x x 座標
     /// @param y y 座標
-    /// @param block 置くべきブロック
+    /// @param orientation 置くべきブロックの向き
     /// @param player ブロックを置くプレイヤー
-    void place(unsigned short x, unsigned short y, const Block &block,
+    void place(unsigned short x, unsigned short y, unsigned short orientation,
                const Player &player) {
-        assert(is_able_to_place(x, y, block, player));
+        assert(is_able_to_place(x, y, orientation, player));
+        TELEMETRY_TIMER(TIMER_PLACE);
         // ターンを 1 増やす
         current_turn++;
         // 埋めるべきフィールドの値は, 上位 6 bit をターン, 下位 2 bit
         // をプレイヤーの番号としたもの
         unsigned short field_value = (current_turn << 2) | player;
-        _field[x][y] = field_value;
-        for(const Direction &direction : block) {
-            x += direction.dx;
-            y += direction.dy;
-            _field[x][y] = field_value;
+        const Orientation &block = ORIENTATIONS[orientation];
+        for(unsigned short i = 0; i < block.cell_size; i++) {
+            _field[x + block.cells[i].x][y + block.cells[i].y] = field_value;
+        }
+        update_hash(x, y, orientation, player);
+        const FieldBoard mask = mask_at(x, y, orientation);
+        const bool is_first_block = _state.boards[player].none();
+        _occupied |= mask;
+        _state.boards[player] |= mask;
+        if(is_first_block) {
+            // 初手では START_POSITIONS[player] を角の候補から外す
+            update_masks(player);
+        } else {
+            _forbidden[player] |= Geometry::adjacent_neighbours(mask);
+            _corners[player] =
+                (_corners[player] | Geometry::diagonal_neighbours(mask)) &
+                ~_forbidden[player];
+        }
+        assert(!_state.is_used(player, block.block));
+        _state.remaining[player] &= ~(1u << block.block);
+        _state.turn = current_turn;
+        _state.player = (player + 1) % PLAYER_SIZE;
+        if constexpr (rule_passes<Rules>()) {
+            _passed_marks.push_back(_state.passed);
         }
     }
 
-    /// @brief 座標 (x, y) からブロック block を除去可能か判断する.
+    /// @brief 座標 (x, y) を左上とするブロックを除去可能か判断する.
     /// @param x x 座標
     /// @param y y 座標
-    /// @param block 除去するブロック
-    bool is_able_to_remove(unsigned short x, unsigned short y, Block &block) {
+    /// @param orientation 除去するブロックの向き
+    bool is_able_to_remove(unsigned short x, unsigned short y,
+                           unsigned short orientation) const {
         assert(is_in_field(x, y));
-        unsigned short field_value = _field[x][y];
-        for(const Direction &direction : block) {
-            x += direction.dx;
-            y += direction.dy;
-            // フィールド外からはみ出ていたら false を返す
-            if(!is_in_field(x, y)) {
-                return false;
-            }
+        // フィールド外からはみ出ていたら false を返す
+        if(!fits_in_field(x, y, orientation)) {
+            return false;
+        }
+        const Orientation &block = ORIENTATIONS[orientation];
+        const short field_value = _field[x + block.cells[0].x][y + block.cells[0].y];
+        for(unsigned short i = 0; i < block.cell_size; i++) {
             // 指定していた形の通りにブロックが置かれていなければ false を返す
-            if(_field[x][y] != field_value) {
+            if(_field[x + block.cells[i].x][y + block.cells[i].y] !=
+               field_value) {
                 return false;
             }
         }
-        return true;
+        return field_value != 0;
     }
 
-    /// @brief 座標 (x, y) からブロック block を除去する.
+    /// @brief 座標 (x, y) を左上とするブロックを除去する.
     /// @param x x 座標
     /// @param y y 座標
-    /// @param block 除去するブロック
-    void remove(unsigned short x, unsigned short y, Block &block) {
-        assert(is_able_to_remove(x, y, block));
-        // ターンを 1 減らす
+    /// @param orientation 除去するブロックの向き
+    void remove(unsigned short x, unsigned short y,
+                unsigned short orientation) {
+        assert(is_able_to_remove(x, y, orientation));
+        TELEMETRY_TIMER(TIMER_REMOVE);
+        const Orientation &block = ORIENTATIONS[orientation];
+        const Player player = static_cast<Player>(
+            _field[x + block.cells[0].x][y + block.cells[0].y] & 0b11);
+        // _passed_marks から書き戻すので, 最後に置いたブロックしか取り除けない
+        assert((_field[x + block.cells[0].x][y + block.cells[0].y] >> 2) ==
+               current_turn);
+        if constexpr (rule_passes<Rules>()) {
+            _state.passed = _passed_marks.back();
+            _passed_marks.pop_back();
+        }
+        _state.remaining[player] |= 1u << block.block;
+        // ターンを 1 減らし, 手番を置いたプレイヤーに戻す
         current_turn--;
+        _state.turn = current_turn;
+        _state.player = player;
         // ブロックが置いてあるマスをすべて 0 にする
-        _field[x][y] = 0;
-        for(const Direction &direction : block) {
-            x += direction.dx;
-            y += direction.dy;
-            _field[x][y] = 0;
+        for(unsigned short i = 0; i < block.cell_size; i++) {
+            _field[x + block.cells[i].x][y + block.cells[i].y] = 0;
         }
+        update_hash(x, y, orientation, player);
+        const FieldBoard inverted = ~mask_at(x, y, orientation);
+        _occupied &= inverted;
+        _state.boards[player] &= inverted;
+        // 隣接マスは他のブロックと共有されうるので, 盤面から計算し直す
+        update_masks(player);
     }
 
     /// @brief _field を指定したファイルパスに出力する
     /// @param file_path 出力先のファイルパス
-    void save_to_file(const std::string &file_path) {
+    void save_to_file(const std::string &file_path) const {
         std::ofstream file(file_path);
         if(!file) {
             throw std::runtime_error("Failed to open file: " + file_path);
         }
+        write(file);
+    }
 
+    /// @brief _field を save_to_file と同じ形式で stream に出力する
+    void write(std::ostream &stream) const {
         for(const auto &row : _field) {
             for(const auto &cell : row) {
-                file << cell << ' ';
+                stream << cell << ' ';
             }
-            file << '\n';
+            stream << '\n';
         }
     }
 
-    void show() {
+    void show() const {
         for(const auto &row : _field) {
             for(const auto &cell : row) {
                 std::cerr << std::setw(2) << std::setfill('0') << (cell & 0b11)
@@ -236,3 +564,23 @@ class Field {
         std::cerr << std::endl;
     }
 };
+
+/// @brief 通常のブロックスのフィールド
+using Field = BasicField<ClassicRules>;
+
+/// @brief 探索 (BasicSolver) が使うフィールドの操作. ビットボードの BasicField
+/// と, 番兵付きの配列の BasicMailboxField (mailbox_field.hpp) が満たす
+template <class F>
+concept FieldBackend = requires(F field, const F &view, const Player &player,
+                                unsigned short n, std::vector<Move> &moves) {
+    { view.current_turn } -> std::convertible_to<unsigned short>;
+    { view.state() } -> std::same_as<const typename F::GameState &>;
+    { view.hash() } -> std::same_as<std::uint64_t>;
+    { view.is_able_to_place(n, n, n, player) } -> std::same_as<bool>;
+    { view.generate_moves(player, moves) };
+    { view.count_moves(player) } -> std::same_as<std::size_t>;
+    { field.pass_dead_players() } -> std::same_as<bool>;
+    { field.place(n, n, n, player) };
+    { field.remove(n, n, n) };
+    { view.save_to_file(std::string()) };
+};
@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma once
+#include "field.hpp"
+#include "game_state.hpp"
+#include "move.hpp"
+#include "players.hpp"
+#include "rules.hpp"
+
+// 局面のファイルを読み書きするときのバッファの大きさ (バイト)
+constexpr std::size_t FRONTIER_IO_BUFFER_SIZE = 1 << 20;
+// 1 回の併合で同時に開くファイルの数の上限. 超えたら何回かに分けて併合する
+constexpr std::size_t FRONTIER_MERGE_FAN_IN = 64;
+// 展開するスレッドが入力から 1 度に取る局面の数
+constexpr std::size_t FRONTIER_EXPAND_BATCH = 256;
+
+/// @brief 幅優先探索の設定
+/// - directory: 各手数の局面とソート済みの断片を書き出すディレクトリ
+/// - memory_size: 断片をソートするバッファの大きさの合計 (バイト).
+///   スレッドで等分する
+/// - thread_size: 展開と断片のソート, 併合を行うスレッドの数
+/// - keep_levels: true なら各手数の局面のファイルを消さずに残す
+struct FrontierOptions {
+    std::string directory = "../output/frontier";
+    std::size_t memory_size = std::size_t(256) << 20;
+    unsigned short thread_size = 1;
+    bool keep_levels = false;
+};
+
+/// @brief 幅優先探索の 1 手分の集計
+/// - distinct: 相異なる局面 (各プレイヤーの盤面, 残りのブロック, 手番) の数
+/// - nodes: 手順が違えば別に数えた局面の数 (Solver::count と同じ)
+/// - complete_games: 全プレイヤーがすべてのブロックを使い切った局面の数
+///   (手順が違えば別に数える), distinct_complete_games はその相異なる数
+struct FrontierLevel {
+    unsigned short depth = 0;
+    unsigned long long distinct = 0;
+    unsigned long long nodes = 0;
+    unsigned long long complete_games = 0;
+    unsigned long long distinct_complete_games = 0;
+};
+
+/// @brief ルール Rules の探索木を 1 手ずつ幅優先でたどり, 手数ごとの
+/// 相異なる局面の数を数える. 各手数の局面は (局面, 手順の数) の組として
+/// ソート済みで重複のないファイルに置き, 次の手数ではそれぞれを 1 回だけ
+/// 展開して子に手順の数を引き継ぐ. 子はメモリに収まる分ずつソートして
+/// 重複をまとめた断片に書き出し, 断片を併合して次の手数のファイルにする
+/// (外部マージソート). ファイルは先頭から順にしか読み書きしないので,
+/// メモリに収まらない数の局面でも数えられる
+template <class Rules>
+class BasicFrontierSearch {
+    using Field = BasicField<Rules>;
+    using GameState = BasicGameState<Rules>;
+    static constexpr bool PASSING = rule_passes<Rules>();
+
+    /// @brief ファイルに書き出す局面. count はその局面に至る手順の数
+    struct Record {
+        GameState state;
+        std::uint64_t count;
+    };
+
+    /// @brief Record を先頭から順に書き出すファイル
+    class RecordWriter {
+        std::FILE *_file;
+        std::string _path;
+
+       public:
+        explicit RecordWriter(const std::string &path)
+            : _file(std::fopen(path.c_str(), "wb")), _path(path) {
+            if (_file == nullptr) {
+                throw std::runtime_error("Failed to open file: " + path);
+            }
+            std::setvbuf(_file, nullptr, _IOFBF, FRONTIER_IO_BUFFER_SIZE);
+        }
+        RecordWriter(const RecordWriter &) = delete;
+        RecordWriter &operator=(const RecordWriter &) = delete;
+        ~RecordWriter() {
+            if (_file != nullptr) {
+                std::fclose(_file);
+            }
+        }
+
+        void write(const Record &record) {
+            if (std::fwrite(&record, sizeof(Record), 1, _file) != 1) {
+                throw std::runtime_error("Failed to write file: " + _path);
+            }
+        }
+
+        /// @brief 書き出しを終える. バッファに残った分の失敗もここで投げる
+        void close() {
+            std::FILE *file = _file;
+            _file = nullptr;
+            if (std::fclose(file) != 0) {
+                throw std::runtime_error("Failed to write file: " + _path);
+            }
+        }
+    };
+
+    /// @brief Record を先頭から順に読むファイル
+    class RecordReader {
+        std::FILE *_file;
+        std::string _path;
+
+       public:
+        explicit RecordReader(const std::string &path)
+            : _file(std::fopen(path.c_str(), "rb")), _path(path) {
+            if (_file == nullptr) {
+                throw std::runtime_error("Failed to open file: " + path);
+            }
+            std::setvbuf(_file, nullptr, _IOFBF, FRONTIER_IO_BUFFER_SIZE);
+        }
+        RecordReader(const RecordReader &) = delete;
+        RecordReader &operator=(const RecordReader &) = delete;
+        ~RecordReader() { std::fclose(_file); }
+
+        /// @brief 次の局面を record に読む. 終わりに達したら false
+        bool read(Record &record) {
+            if (std::fread(&record, sizeof(Record), 1, _file) == 1) {
+                return true;
+            }
+            if (std::ferror(_file)) {
+                throw std::runtime_error("Failed to read file: " + _path);
+            }
+            return false;
+        }
+
+        /// @brief 最大 size 個の局面を records に読み, 読んだ数を返す
+        std::size_t read(Record *records, std::size_t size) {
+            const std::size_t read_size =
+                std::fread(records, sizeof(Record), size, _file);
+            if (read_size < size and std::ferror(_file)) {
+                throw std::runtime_error("Failed to read file: " + _path);
+            }
+            return read_size;
+        }
+    };
+
+    FrontierOptions _options;
+    // 書き出した断片の数. ファイル名に使う
+    std::atomic<unsigned long long> _run_count{0};
+
+    /// @brief 局面の並びの比較. 手番, 残りのブロック, 盤面の順に比べる.
+    /// ターン数は同じ手数では等しく, パスしたプレイヤーは盤面から決まるので
+    /// 比べない
+    static int compare(const GameState &lhs, const GameState &rhs) {
+        if (lhs.player != rhs.player) {
+            return lhs.player < rhs.player ? -1 : 1;
+        }
+        if (lhs.remaining != rhs.remaining) {
+            return lhs.remaining < rhs.remaining ? -1 : 1;
+        }
+        for (unsigned short player = 0; player < Rules::PLAYER_SIZE;
+             player++) {
+            for (std::size_t j = 0; j < GameState::Board::WORD_SIZE; j++) {
+                const std::uint64_t left = lhs.boards[player].word(j);
+                const std::uint64_t right = rhs.boards[player].word(j);
+                if (left != right) {
+                    return left < right ? -1 : 1;
+                }
+            }
+        }
+        return 0;
+    }
+
+    std::string level_path(unsigned short depth) const {
+        return _options.directory + "/level-" + std::to_string(depth);
+    }
+
+    std::string next_run_path() {
+        return _options.directory + "/run-" + std::to_string(_run_count++);
+    }
+
+    /// @brief records をソートして同じ局面の手順の数をまとめ, 断片に書き出す
+    std::string write_run(std::vector<Record> &records) {
+        std::sort(records.begin(), records.end(),
+                  [](const Record &lhs, const Record &rhs) {
+                      return compare(lhs.state, rhs.state) < 0;
+                  });
+        const std::string path = next_run_path();
+        RecordWriter writer(path);
+        for (std::size_t i = 0; i < records.size();) {
+            Record record = records[i++];
+            while (i < records.size() and
+                   compare(records[i].state, record.state) == 0) {
+                record.count += records[i++].count;
+            }
+            writer.write(record);
+        }
+        writer.close();
+        records.clear();
+        return path;
+    }
+
+    /// @brief 入力の局面を取り合いながら展開し, 子を断片に書き出す
+    void expand(RecordReader &input, std::mutex &input_mutex,
+                std::vector<std::string> &runs, std::mutex &runs_mutex) {
+        const std::size_t capacity = std::max<std::size_t>(
+            _options.memory_size / _options.thread_size / sizeof(Record),
+            1024);
+        std::vector<Record> children;
+        children.reserve(capacity);
+        std::vector<Record> batch(FRONTIER_EXPAND_BATCH);
+        std::vector<Move> moves;
+        const auto flush = [&] {
+            const std::string path = write_run(children);
+            std::lock_guard<std::mutex> lock(runs_mutex);
+            runs.push_back(path);
+        };
+        while (true) {
+            std::size_t batch_size;
+            {
+                std::lock_guard<std::mutex> lock(input_mutex);
+                batch_size = input.read(batch.data(), batch.size());
+            }
+            if (batch_size == 0) {
+                break;
+            }
+            for (std::size_t i = 0; i < batch_size; i++) {
+                const Record &parent = batch[i];
+                if (parent.state.is_all_blocks_used()) {
+                    continue;
+                }
+                Field field(parent.state);
+                if constexpr (PASSING) {
+                    if (!field.pass_dead_players()) {
+                        continue;
+                    }
+                }
+                field.generate_moves(static_cast<Player>(field.state().player),
+                                     moves);
+                // 子の局面は Field に置かずに GameState だけで作る
+                for (const Move &move : moves) {
+                    if (children.size() == capacity) {
+                        flush();
+                    }
+                    children.push_back({field.state(), parent.count});
+                    children.back().state.play(move);
+                }
+            }
+        }
+        if (!children.empty()) {
+            flush();
+        }
+    }
+
+    /// @brief ソート済みの inputs を併合し, 同じ局面の手順の数をまとめて
+    /// output に書き出す. level が nullptr でなければ書き出した局面を数える
+    static void merge(const std::vector<std::string> &inputs,
+                      const std::string &output, FrontierLevel *level) {
+        std::vector<std::unique_ptr<RecordReader>> readers;
+        std::vector<Record> heads(inputs.size());
+        // heads の添字を, 局面の小さい順に取り出す
+        const auto greater = [&heads](std::size_t lhs, std::size_t rhs) {
+            return compare(heads[lhs].state, heads[rhs].state) > 0;
+        };
+        std::priority_queue<std::size_t, std::vector<std::size_t>,
+                            decltype(greater)>
+            queue(greater);
+        for (std::size_t i = 0; i < inputs.size(); i++) {
+            readers.push_back(std::make_unique<RecordReader>(inputs[i]));
+            if (readers[i]->read(heads[i])) {
+                queue.push(i);
+            }
+        }
+        RecordWriter writer(output);
+        const auto emit = [&](const Record &record) {
+            writer.write(record);
+            if (level != nullptr) {
+                level->distinct++;
+                level->nodes += record.count;
+                if (record.state.is_all_blocks_used()) {
+                    level->distinct_complete_games++;
+                    level->complete_games += record.count;
+                }
+            }
+        };
+        Record pending;
+        bool has_pending = false;
+        while (!queue.empty()) {
+            const std::size_t i = queue.top();
+            queue.pop();
+            if (has_pending and compare(pending.state, heads[i].state) == 0) {
+                pending.count += heads[i].count;
+            } else {
+                if (has_pending) {
+                    emit(pending);
+                }
+                pending = heads[i];
+                has_pending = true;
+            }
+            if (readers[i]->read(heads[i])) {
+                queue.push(i);
+            }
+        }
+        if (has_pending) {
+            emit(pending);
+        }
+        writer.close();
+    }
+
+    /// @brief f(worker) を thread_size 個のスレッドで実行し, どれかが
+    /// 例外を投げたら全員の終了後に投げ直す
+    template <class F>
+    void run_workers(unsigned short thread_size, F &&f) {
+        std::vector<std::exception_ptr> errors(thread_size);
+        std::vector<std::thread> workers;
+        for (unsigned short worker = 0; worker < thread_size; worker++) {
+            workers.emplace_back([&f, &errors, worker] {
+                try {
+                    f(worker);
+                } catch (...) {
+                    errors[worker] = std::current_exception();
+                }
+            });
+        }
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        for (const std::exception_ptr &error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    /// @brief 断片を FRONTIER_MERGE_FAN_IN 個ずつ並列に併合して,
+    /// 一度に併合できる数まで減らす
+    void reduce_runs(std::vector<std::string> &runs) {
+        while (runs.size() > FRONTIER_MERGE_FAN_IN) {
+            std::vector<std::vector<std::string>> groups;
+            for (std::size_t i = 0; i < runs.size();
+                 i += FRONTIER_MERGE_FAN_IN) {
+                groups.emplace_back(
+                    runs.begin() + i,
+                    runs.begin() +
+                        std::min(i + FRONTIER_MERGE_FAN_IN, runs.size()));
+            }
+            std::vector<std::string> merged(groups.size());
+            for (std::string &path : merged) {
+                path = next_run_path();
+            }
+            std::atomic<std::size_t> next{0};
+            run_workers(_options.thread_size, [&](unsigned short) {
+                for (std::size_t group = next++; group < groups.size();
+                     group = next++) {
+                    merge(groups[group], merged[group], nullptr);
+                    for (const std::string &path : groups[group]) {
+                        std::filesystem::remove(path);
+                    }
+                }
+            });
+            runs = std::move(merged);
+        }
+    }
+
+   public:
+    explicit BasicFrontierSearch(const FrontierOptions &options)
+        : _options(options) {
+        _options.thread_size =
+            std::max<unsigned short>(_options.thread_size, 1);
+    }
+
+    /// @brief root を置いた局面から depth 手先までを 1 手ずつ展開し,
+    /// 手数ごとの集計を返す. 根の局面は数えない
+    std::vector<FrontierLevel> search(const std::vector<Move> &root,
+                                      unsigned short depth) {
+        std::filesystem::create_directories(_options.directory);
+        Field field;
+        for (const Move &move : root) {
+            if constexpr (PASSING) {
+                field.pass_dead_players();
+            }
+            field.place(move.position.x, move.position.y, move.orientation,
+                        static_cast<Player>(field.state().player));
+        }
+        {
+            RecordWriter writer(level_path(0));
+            writer.write({field.state(), 1});
+            writer.close();
+        }
+
+        std::vector<FrontierLevel> levels;
+        for (unsigned short level = 1; level <= depth; level++) {
+            std::vector<std::string> runs;
+            {
+                RecordReader input(level_path(level - 1));
+                std::mutex input_mutex, runs_mutex;
+                run_workers(_options.thread_size, [&](unsigned short) {
+                    expand(input, input_mutex, runs, runs_mutex);
+                });
+            }
+            if (!_options.keep_levels) {
+                std::filesystem::remove(level_path(level - 1));
+            }
+            reduce_runs(runs);
+            FrontierLevel result;
+            result.depth = level;
+            merge(runs, level_path(level), &result);
+            for (const std::string &path : runs) {
+                std::filesystem::remove(path);
+            }
+            levels.push_back(result);
+            if (result.distinct == result.distinct_complete_games) {
+                break;
+            }
+        }
+        if (!_options.keep_levels) {
+            std::filesystem::remove(level_path(levels.size()));
+        }
+        return levels;
+    }
+};
+
+/// @brief 通常のブロックスの幅優先探索
+using FrontierSearch = BasicFrontierSearch<ClassicRules>;
@@ -0,0 +1,122 @@
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#pragma once
+#include "bitboard.hpp"
+#include "move.hpp"
+#include "pieces.hpp"
+#include "players.hpp"
+#include "rules.hpp"
+
+/// @brief ルール Rules の局面を詰めて表す値. 局面から一意に決まるものだけを持ち,
+/// memcpy でコピーできる (並列探索のタスク, チェックポイント, 置換表のキーに使う).
+/// - boards[p]: プレイヤー p のブロックが置かれているマス (x * FIELD_WIDTH + y)
+/// - remaining[p]: プレイヤー p がまだ使っていないブロックの集合
+///   (ビット i がブロック i). ルールで使わないブロックは最初から 0
+/// - player: 手番のプレイヤー
+/// - turn: これまでに置いたブロックの数
+/// - passed: 合法手が無くなってパスしたプレイヤーの集合 (ビット p).
+///   パスしたかどうかは盤面から決まるので, 置換表のキーには含めない
+///
+/// 通常のルールでは 4 x 56 バイトの盤面と 4 x 4 バイトの集合で 248 バイト
+template <class Rules>
+struct BasicGameState {
+    static constexpr std::size_t FIELD_WIDTH = Rules::FIELD_WIDTH;
+    static constexpr unsigned short PLAYER_SIZE = Rules::PLAYER_SIZE;
+    using Board = Bitboard<FIELD_WIDTH * FIELD_WIDTH>;
+
+    std::array<Board, PLAYER_SIZE> boards{};
+    std::array<std::uint32_t, PLAYER_SIZE> remaining{};
+    std::uint8_t player = 0;
+    std::uint8_t turn = 0;
+    std::uint8_t passed = 0;
+
+    /// @brief 初期局面 (どのブロックも置かれておらず, 最初のプレイヤーの手番)
+    static constexpr BasicGameState initial() {
+        BasicGameState state;
+        state.remaining.fill(Rules::BLOCKS);
+        return state;
+    }
+
+    /// @brief いずれかのプレイヤーのブロックが置かれているマス
+    constexpr Board occupied() const {
+        Board result;
+        for (const Board &board : boards) {
+            result |= board;
+        }
+        return result;
+    }
+
+    constexpr bool is_used(unsigned short player_,
+                           unsigned short block) const {
+        return !((remaining[player_] >> block) & 1);
+    }
+
+    /// @brief プレイヤー player_ の使用済みブロックの集合
+    constexpr std::uint32_t used_blocks(unsigned short player_) const {
+        return ALL_BLOCKS & ~remaining[player_];
+    }
+
+    /// @brief プレイヤー player_ の残りのブロックの数
+    constexpr unsigned short blocks_left(unsigned short player_) const {
+        return std::popcount(remaining[player_]);
+    }
+
+    /// @brief 全プレイヤーの残りのブロックの数の合計
+    constexpr unsigned short blocks_left() const {
+        unsigned short result = 0;
+        for (const std::uint32_t blocks : remaining) {
+            result += std::popcount(blocks);
+        }
+        return result;
+    }
+
+    /// @brief 全プレイヤーがすべてのブロックを使い切ったかどうか
+    constexpr bool is_all_blocks_used() const {
+        std::uint32_t blocks = 0;
+        for (const std::uint32_t player_blocks : remaining) {
+            blocks |= player_blocks;
+        }
+        return blocks == 0;
+    }
+
+    /// @brief 手番のプレイヤーが move を置き, 次のプレイヤーの手番にする.
+    /// 置けるかどうかも, 次のプレイヤーがパスするかどうかも調べない
+    constexpr void play(const Move &move) {
+        const Orientation &orientation = ORIENTATIONS[move.orientation];
+        for (unsigned short i = 0; i < orientation.cell_size; i++) {
+            boards[player].set(
+                (move.position.x + orientation.cells[i].x) * FIELD_WIDTH +
+                move.position.y + orientation.cells[i].y);
+        }
+        remaining[player] &= ~(std::uint32_t(1) << orientation.block);
+        turn++;
+        player = (player + 1) % PLAYER_SIZE;
+    }
+
+    /// @brief 直前に置かれた move を取り除き, 手番を戻す.
+    /// play の後にパスが無かったものとする
+    constexpr void undo(const Move &move) {
+        turn--;
+        player = (player + PLAYER_SIZE - 1) % PLAYER_SIZE;
+        const Orientation &orientation = ORIENTATIONS[move.orientation];
+        for (unsigned short i = 0; i < orientation.cell_size; i++) {
+            boards[player].reset(
+                (move.position.x + orientation.cells[i].x) * FIELD_WIDTH +
+                move.position.y + orientation.cells[i].y);
+        }
+        remaining[player] |= std::uint32_t(1) << orientation.block;
+    }
+
+    friend constexpr bool operator==(const BasicGameState &,
+                                     const BasicGameState &) = default;
+};
+
+/// @brief 通常のブロックスの局面
+using GameState = BasicGameState<ClassicRules>;
+
+static_assert(std::is_trivially_copyable_v<GameState>);
+static_assert(sizeof(GameState) <= 256);
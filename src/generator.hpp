@@ -0,0 +1,103 @@
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#pragma once
+
+/// @brief co_yield で値を 1 つずつ返すコルーチンの戻り値 (C++23 の
+/// std::generator の代わり). 範囲 for で回すと, 次の値を取り出すときに
+/// 初めてコルーチンを再開する. 途中で break すればコルーチンの残りは
+/// 実行せずに破棄する.
+/// 取り出した値は co_yield に渡した式を参照するので, 次の値を取り出すまで有効
+template <class T>
+class Generator {
+   public:
+    struct promise_type {
+        const T *value = nullptr;
+        std::exception_ptr exception;
+
+        Generator get_return_object() {
+            return Generator(
+                std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(const T &yielded) noexcept {
+            value = std::addressof(yielded);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+        // co_await は使わない
+        template <class U>
+        U &&await_transform(U &&) = delete;
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    class iterator {
+        Handle _handle;
+
+       public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(Handle handle) : _handle(handle) {}
+
+        const T &operator*() const { return *_handle.promise().value; }
+        const T *operator->() const { return _handle.promise().value; }
+
+        iterator &operator++() {
+            resume(_handle);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator &it, std::default_sentinel_t) {
+            return it._handle == nullptr or it._handle.done();
+        }
+    };
+
+    Generator(Generator &&other) noexcept
+        : _handle(std::exchange(other._handle, nullptr)) {}
+    Generator &operator=(Generator &&other) noexcept {
+        if (this != &other) {
+            destroy();
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+    ~Generator() { destroy(); }
+
+    /// @brief 最初の値までコルーチンを進める. 1 つの Generator につき 1 回だけ
+    iterator begin() {
+        resume(_handle);
+        return iterator(_handle);
+    }
+    std::default_sentinel_t end() const { return {}; }
+
+   private:
+    Handle _handle;
+
+    explicit Generator(Handle handle) : _handle(handle) {}
+
+    /// @brief 次の co_yield か終わりまで進め, コルーチン内の例外を投げ直す
+    static void resume(Handle handle) {
+        handle.resume();
+        if (handle.promise().exception) {
+            std::rethrow_exception(handle.promise().exception);
+        }
+    }
+
+    void destroy() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+};
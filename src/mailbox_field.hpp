@@ -0,0 +1,542 @@
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#pragma once
+#include "field.hpp"
+#include "game_state.hpp"
+#include "move.hpp"
+#include "pieces.hpp"
+#include "players.hpp"
+#include "position.hpp"
+#include "rules.hpp"
+#include "telemetry.hpp"
+
+/// @brief ルール Rules のフィールドを, 周りを番兵で囲んだ 1 次元配列
+/// (メールボックス) で表すときの表. どれもコンパイル時に作る.
+/// マス (x, y) は (x + PADDING) * STRIDE + y + PADDING 番目の要素で,
+/// 隣のマスへは添字に定数を足すだけで移れる
+template <class Rules>
+struct MailboxGeometry {
+    // フィールドの縦横の長さ
+    static constexpr std::size_t FIELD_WIDTH = Rules::FIELD_WIDTH;
+    // フィールドの周りの番兵の幅. 角のマスに合わせたブロックがフィールドから
+    // はみ出しても, そのマスと 4 近傍は番兵の内側に収まる
+    static constexpr std::size_t PADDING = MAX_BLOCK_CELL_SIZE;
+    // 1 行の要素数と, 配列の要素数
+    static constexpr std::size_t STRIDE = FIELD_WIDTH + 2 * PADDING;
+    static constexpr std::size_t PADDED_SIZE = STRIDE * STRIDE;
+    // 配列の要素 1 つにつき 1 ビットの集合の語数
+    static constexpr std::size_t PADDED_WORD_SIZE = (PADDED_SIZE + 63) / 64;
+
+    static_assert(PADDED_SIZE <= 1 << 16);
+
+    /// @brief マス (x, y) の配列の添字
+    static constexpr std::size_t index_of(std::size_t x, std::size_t y) {
+        return (x + PADDING) * STRIDE + y + PADDING;
+    }
+
+    /// @brief 配列の添字 index がフィールドのマスかどうか
+    static constexpr bool is_in_field(std::size_t index) {
+        return index / STRIDE - PADDING < FIELD_WIDTH and
+               index % STRIDE - PADDING < FIELD_WIDTH;
+    }
+
+    /// @brief 向き ORIENTATIONS[i] のブロックの, 左上のマスからの添字の差.
+    /// - cells: ブロックのマス
+    /// - edges: ブロックのマスと辺で接し, ブロックに含まれないマス
+    /// - corners: ブロックのマスと斜めにだけ接するマス
+    struct PieceOffsets {
+        std::array<int, MAX_BLOCK_CELL_SIZE> cells{};
+        std::array<int, 4 * MAX_BLOCK_CELL_SIZE> edges{};
+        std::array<int, 4 * MAX_BLOCK_CELL_SIZE> corners{};
+        unsigned short cell_size = 0;
+        unsigned short edge_size = 0;
+        unsigned short corner_size = 0;
+    };
+
+    // 各向きのブロックの添字の差. 添字は ORIENTATIONS と共通
+    static constexpr std::array<PieceOffsets, ORIENTATION_SIZE> PIECE_OFFSETS =
+        [] {
+            std::array<PieceOffsets, ORIENTATION_SIZE> offsets{};
+            // バウンディングボックスを 1 マスずつ広げた範囲でマスを分類する
+            constexpr int SIZE = MAX_BLOCK_CELL_SIZE + 2;
+            for(std::size_t i = 0; i < ORIENTATION_SIZE; i++) {
+                const Orientation &orientation = ORIENTATIONS[i];
+                std::array<std::array<bool, SIZE>, SIZE> covered{};
+                for(unsigned short j = 0; j < orientation.cell_size; j++) {
+                    const Position &cell = orientation.cells[j];
+                    covered[cell.x + 1][cell.y + 1] = true;
+                    offsets[i].cells[offsets[i].cell_size++] =
+                        cell.x * STRIDE + cell.y;
+                }
+                for(int x = 0; x < SIZE; x++) {
+                    for(int y = 0; y < SIZE; y++) {
+                        if(covered[x][y]) {
+                            continue;
+                        }
+                        const auto at = [&](int dx, int dy) {
+                            return x + dx >= 0 and x + dx < SIZE and
+                                   y + dy >= 0 and y + dy < SIZE and
+                                   covered[x + dx][y + dy];
+                        };
+                        const int offset = (x - 1) * static_cast<int>(STRIDE) +
+                                           (y - 1);
+                        if(at(-1, 0) or at(1, 0) or at(0, -1) or at(0, 1)) {
+                            offsets[i].edges[offsets[i].edge_size++] = offset;
+                        } else if(at(-1, -1) or at(-1, 1) or at(1, -1) or
+                                  at(1, 1)) {
+                            offsets[i].corners[offsets[i].corner_size++] =
+                                offset;
+                        }
+                    }
+                }
+            }
+            return offsets;
+        }();
+
+    // 上下左右と斜めの隣のマスへの添字の差
+    static constexpr std::array<int, 4> ADJACENT_OFFSETS = {
+        -static_cast<int>(STRIDE), static_cast<int>(STRIDE), -1, 1};
+    static constexpr std::array<int, 4> DIAGONAL_OFFSETS = {
+        -static_cast<int>(STRIDE) - 1, -static_cast<int>(STRIDE) + 1,
+        static_cast<int>(STRIDE) - 1, static_cast<int>(STRIDE) + 1};
+};
+
+/// @brief BasicField と同じ操作を, ビットボードを使わずに番兵付きの
+/// 1 次元配列で行うフィールド. 探索の速さを BasicField と比べるためのもので,
+/// 合法手は BasicField と同じ順に生成する.
+/// - _owners: 各マスのブロックの持ち主 (プレイヤー p なら 1 << p,
+///   空きマスなら 0, 番兵なら WALL)
+/// - _values: 各マスの値 (BasicField の _field と同じ. 番兵は -1)
+///
+/// 配置判定はブロックのマスとその周りのマスを, あらかじめ求めた添字の差で
+/// 引くだけで行う. フィールドからはみ出したマスは番兵に当たるので,
+/// 座標の範囲は調べない. 合法手は角のマスに各向きのブロックの各マスを
+/// 合わせた左上のマスだけを調べる
+template <class Rules>
+class BasicMailboxField {
+  public:
+    using Geometry = MailboxGeometry<Rules>;
+    using GameState = BasicGameState<Rules>;
+    static constexpr std::size_t FIELD_WIDTH = Geometry::FIELD_WIDTH;
+    static constexpr std::size_t FIELD_CELL_SIZE = FIELD_WIDTH * FIELD_WIDTH;
+    static constexpr unsigned short PLAYER_SIZE = Rules::PLAYER_SIZE;
+    static constexpr const auto &START_POSITIONS = Rules::START_POSITIONS;
+    // 局面から再現したブロックのマスに書くターン (BasicField と同じ)
+    static constexpr unsigned short UNKNOWN_TURN = rule_max_turn<Rules>() + 1;
+
+  private:
+    static constexpr std::size_t STRIDE = Geometry::STRIDE;
+    static constexpr std::size_t PADDING = Geometry::PADDING;
+    static constexpr std::size_t PADDED_SIZE = Geometry::PADDED_SIZE;
+    static constexpr std::size_t PADDED_WORD_SIZE = Geometry::PADDED_WORD_SIZE;
+    using PieceOffsets = typename Geometry::PieceOffsets;
+    static constexpr const auto &PIECE_OFFSETS = Geometry::PIECE_OFFSETS;
+    static constexpr const auto &ZOBRIST_KEYS =
+        FieldGeometry<Rules>::ZOBRIST_KEYS;
+    // 番兵の _owners の値. どのプレイヤーのビットとも重ならない
+    static constexpr std::uint8_t WALL = 0x80;
+
+    std::array<std::uint8_t, PADDED_SIZE> _owners{};
+    std::array<short, PADDED_SIZE> _values{};
+    // 盤面と使用済みブロックの Zobrist ハッシュ. place / remove で更新する
+    std::uint64_t _hash = 0;
+    // 各プレイヤーの盤面, 残りのブロック, 手番. place / remove で更新する
+    GameState _state = GameState::initial();
+    // _passed_marks[t] := t + 1 手目を置く直前の _state.passed.
+    // パスするルール (rule_passes) のときだけ積む
+    std::vector<std::uint8_t> _passed_marks;
+
+    /// @brief (x, y) を左上とするブロックの分だけ _hash を XOR で更新する
+    void update_hash(const unsigned short x, const unsigned short y,
+                     const unsigned short orientation, const Player &player) {
+        const Orientation &block = ORIENTATIONS[orientation];
+        for(unsigned short i = 0; i < block.cell_size; i++) {
+            _hash ^= ZOBRIST_KEYS.cells[player][(x + block.cells[i].x) *
+                                                    FIELD_WIDTH +
+                                                y + block.cells[i].y];
+        }
+        _hash ^= ZOBRIST_KEYS.blocks[player][block.block];
+    }
+
+    /// @brief 添字 anchor を左上として向き orientation のブロックを置けるか
+    /// 判断する
+    bool is_placeable(const std::size_t anchor,
+                      const unsigned short orientation,
+                      const Player &player) const {
+        const PieceOffsets &piece = PIECE_OFFSETS[orientation];
+        const std::uint8_t mine = 1u << player;
+        std::uint8_t covered = 0;
+        for(unsigned short i = 0; i < piece.cell_size; i++) {
+            covered |= _owners[anchor + piece.cells[i]];
+        }
+        if(covered != 0) {
+            return false;
+        }
+        std::uint8_t edges = 0;
+        for(unsigned short i = 0; i < piece.edge_size; i++) {
+            edges |= _owners[anchor + piece.edges[i]];
+        }
+        if((edges & mine) != 0) {
+            return false;
+        }
+        if(_state.boards[player].none()) {
+            // 初手では START_POSITIONS[player] を覆っていなければ NG
+            const Position &start = START_POSITIONS[player];
+            const std::size_t start_index =
+                Geometry::index_of(start.x, start.y);
+            for(unsigned short i = 0; i < piece.cell_size; i++) {
+                if(anchor + piece.cells[i] == start_index) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        std::uint8_t corners = 0;
+        for(unsigned short i = 0; i < piece.corner_size; i++) {
+            corners |= _owners[anchor + piece.corners[i]];
+        }
+        return (corners & mine) != 0;
+    }
+
+    /// @brief 角のマスを覆う左上のマス anchor に, 向き orientation の
+    /// ブロックを置けるかを返す. 角を覆うので斜めの条件は調べない.
+    /// COUNT_REJECTIONS なら, 左上がフィールドの中にあって置けないときの
+    /// 理由を telemetry_counters に数え, フィールドに収まれば fitting を 1
+    /// 増やす (BasicField::generate_moves と同じ集合)
+    template <bool COUNT_REJECTIONS>
+    bool is_legal_anchor(const std::size_t anchor,
+                         const unsigned short orientation, const Player &player,
+                         std::size_t &fitting) const {
+        const PieceOffsets &piece = PIECE_OFFSETS[orientation];
+        std::uint8_t covered = 0;
+        for(unsigned short i = 0; i < piece.cell_size; i++) {
+            covered |= _owners[anchor + piece.cells[i]];
+        }
+        std::uint8_t edges = 0;
+        for(unsigned short i = 0; i < piece.edge_size; i++) {
+            edges |= _owners[anchor + piece.edges[i]];
+        }
+        const bool legal = covered == 0 and (edges & (1u << player)) == 0;
+        if constexpr (COUNT_REJECTIONS) {
+            if((covered & WALL) != 0) {
+                if(Geometry::is_in_field(anchor)) {
+                    telemetry_counters.reject(REJECT_OUT_OF_FIELD);
+                }
+            } else {
+                fitting++;
+                if(!legal) {
+                    telemetry_counters.reject(covered != 0
+                                                  ? REJECT_OCCUPIED
+                                                  : REJECT_EDGE_ADJACENT);
+                }
+            }
+        }
+        return legal;
+    }
+
+    /// @brief プレイヤー player の角のマス (空いていて, 斜めに自分のブロックと
+    /// 接し, 辺では接しないマス) の添字を corners に格納し, その数を返す.
+    /// まだブロックを置いていなければ, 空いている START_POSITIONS[player]
+    std::size_t collect_corners(
+        const Player &player,
+        std::array<std::uint16_t, FIELD_CELL_SIZE> &corners) const {
+        std::size_t size = 0;
+        if(_state.boards[player].none()) {
+            const Position &start = START_POSITIONS[player];
+            const std::size_t index = Geometry::index_of(start.x, start.y);
+            corners[0] = index;
+            return _owners[index] == 0;
+        }
+        const std::uint8_t mine = 1u << player;
+        for(std::size_t x = 0; x < FIELD_WIDTH; x++) {
+            for(std::size_t y = 0; y < FIELD_WIDTH; y++) {
+                const std::size_t index = Geometry::index_of(x, y);
+                std::uint8_t edges = 0;
+                std::uint8_t diagonals = 0;
+                for(unsigned short k = 0; k < 4; k++) {
+                    edges |= _owners[index + Geometry::ADJACENT_OFFSETS[k]];
+                    diagonals |= _owners[index + Geometry::DIAGONAL_OFFSETS[k]];
+                }
+                corners[size] = index;
+                size += _owners[index] == 0 and (edges & mine) == 0 and
+                        (diagonals & mine) != 0;
+            }
+        }
+        return size;
+    }
+
+    /// @brief プレイヤー player の合法手を, 向き, 左上のマスの順に
+    /// f(orientation, x, y) に渡す. f が false を返したら打ち切る.
+    /// COUNT_REJECTIONS なら置けなかった理由を telemetry_counters に数える
+    /// @return 打ち切ったかどうか
+    template <bool COUNT_REJECTIONS = false, class F>
+    bool for_each_move(const Player &player, F &&f) const {
+        std::array<std::uint16_t, FIELD_CELL_SIZE> corners;
+        const std::size_t corner_size = collect_corners(player, corners);
+        if(corner_size == 0) {
+            return false;
+        }
+        for(unsigned short orientation = 0; orientation < ORIENTATION_SIZE;
+            orientation++) {
+            if(_state.is_used(player, ORIENTATIONS[orientation].block)) {
+                continue;
+            }
+            // 角にブロックの各マスを合わせた左上のマス. 集合にすると
+            // 重複が消え, 添字の順 (= 左上のマスの順) に取り出せる
+            const PieceOffsets &piece = PIECE_OFFSETS[orientation];
+            std::array<std::uint64_t, PADDED_WORD_SIZE> anchors{};
+            for(std::size_t i = 0; i < corner_size; i++) {
+                for(unsigned short j = 0; j < piece.cell_size; j++) {
+                    const std::size_t anchor = corners[i] - piece.cells[j];
+                    anchors[anchor / 64] |= std::uint64_t(1) << (anchor % 64);
+                }
+            }
+            std::size_t fitting = 0;
+            for(std::size_t w = 0; w < PADDED_WORD_SIZE; w++) {
+                for(std::uint64_t word = anchors[w]; word != 0;
+                    word &= word - 1) {
+                    const std::size_t anchor = w * 64 + std::countr_zero(word);
+                    if(is_legal_anchor<COUNT_REJECTIONS>(anchor, orientation,
+                                                         player, fitting) and
+                       !f(orientation, anchor / STRIDE - PADDING,
+                          anchor % STRIDE - PADDING)) {
+                        return true;
+                    }
+                }
+            }
+            if constexpr (COUNT_REJECTIONS) {
+                // フィールドに収まる左上のマスのうち, 角を覆わないもの
+                const Orientation &block = ORIENTATIONS[orientation];
+                telemetry_counters.reject(
+                    REJECT_NO_DIAGONAL_CONTACT,
+                    (FIELD_WIDTH - block.height + 1) *
+                            (FIELD_WIDTH - block.width + 1) -
+                        fitting);
+            }
+        }
+        return false;
+    }
+
+  public:
+    unsigned short current_turn = 0;
+    BasicMailboxField() : BasicMailboxField(GameState::initial()) {}
+
+    /// @brief 局面 state を再現する. state までの手順は分からないので,
+    /// 置かれているマスの値はターンを UNKNOWN_TURN とし,
+    /// そのブロックは remove できない
+    explicit BasicMailboxField(const GameState &state)
+        : _state(state), current_turn(state.turn) {
+        _owners.fill(WALL);
+        _values.fill(-1);
+        for(std::size_t x = 0; x < FIELD_WIDTH; x++) {
+            for(std::size_t y = 0; y < FIELD_WIDTH; y++) {
+                _owners[Geometry::index_of(x, y)] = 0;
+                _values[Geometry::index_of(x, y)] = 0;
+            }
+        }
+        for(unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            for(std::size_t x = 0; x < FIELD_WIDTH; x++) {
+                for(std::size_t y = 0; y < FIELD_WIDTH; y++) {
+                    const std::size_t index = x * FIELD_WIDTH + y;
+                    if(state.boards[player].test(index)) {
+                        _owners[Geometry::index_of(x, y)] = 1u << player;
+                        _values[Geometry::index_of(x, y)] =
+                            (UNKNOWN_TURN << 2) | player;
+                        _hash ^= ZOBRIST_KEYS.cells[player][index];
+                    }
+                }
+            }
+            for(unsigned short block = 0; block < BLOCK_SIZE; block++) {
+                if(state.is_used(player, block) and
+                   ((Rules::BLOCKS >> block) & 1)) {
+                    _hash ^= ZOBRIST_KEYS.blocks[player][block];
+                }
+            }
+        }
+    }
+
+    /// @brief 現在の局面. BasicMailboxField(state) に渡せば再現できる
+    const GameState &state() const { return _state; }
+
+    /// @brief 座標 (x, y) を左上としてブロックを配置可能か判断する.
+    /// 置けなかった理由は数えない (BasicField::is_able_to_place と同じ)
+    bool is_able_to_place(unsigned short x, unsigned short y,
+                          unsigned short orientation,
+                          const Player &player) const {
+        TELEMETRY_TIMER(TIMER_IS_ABLE_TO_PLACE);
+        assert(x < FIELD_WIDTH and y < FIELD_WIDTH);
+        return is_placeable(Geometry::index_of(x, y), orientation, player);
+    }
+
+    /// @brief 局面のハッシュを返す. BasicField::hash と同じ値になる
+    std::uint64_t hash() const {
+        return _hash ^ ZOBRIST_KEYS.turns[_state.player];
+    }
+
+    /// @brief プレイヤー player に合法手があるかどうかを返す.
+    /// パス済みか残りのブロックが無ければ盤面を見ずに false を返す
+    bool can_move(const Player &player) const {
+        if(((_state.passed >> player) & 1) or _state.remaining[player] == 0) {
+            return false;
+        }
+        return for_each_move(player, [](unsigned short, std::size_t,
+                                        std::size_t) { return false; });
+    }
+
+    /// @brief BasicField::pass_dead_players と同じ
+    bool pass_dead_players() {
+        for(unsigned short i = 0; i < PLAYER_SIZE; i++) {
+            const Player player = static_cast<Player>(_state.player);
+            if(can_move(player)) {
+                return true;
+            }
+            _state.passed |= 1u << player;
+            _state.player = (player + 1) % PLAYER_SIZE;
+        }
+        return false;
+    }
+
+    /// @brief プレイヤー player の合法手をすべて moves に格納する.
+    /// 合法手は向き, 左上のマスの順に並ぶ. 使用済みのブロックは除く.
+    /// 置けなかった理由は BasicField と同じ左上のマスの集合で数える
+    void generate_moves(const Player &player, std::vector<Move> &moves) const {
+        TELEMETRY_TIMER(TIMER_GENERATE_MOVES);
+        moves.clear();
+        for_each_move<true>(player, [&](unsigned short orientation,
+                                        std::size_t x, std::size_t y) {
+            moves.emplace_back(orientation, Position(x, y));
+            return true;
+        });
+    }
+
+    /// @brief プレイヤー player の合法手の数を返す. 合法手は作らない
+    std::size_t count_moves(const Player &player) const {
+        std::size_t result = 0;
+        for_each_move(player,
+                      [&](unsigned short, std::size_t, std::size_t) {
+                          result++;
+                          return true;
+                      });
+        return result;
+    }
+
+    /// @brief 座標 (x, y) を左上としてブロックを置く
+    /// @param x x 座標
+    /// @param y y 座標
+    /// @param orientation 置くべきブロックの向き
+    /// @param player ブロックを置くプレイヤー
+    void place(unsigned short x, unsigned short y, unsigned short orientation,
+               const Player &player) {
+        assert(is_able_to_place(x, y, orientation, player));
+        TELEMETRY_TIMER(TIMER_PLACE);
+        current_turn++;
+        const short field_value = (current_turn << 2) | player;
+        const Orientation &block = ORIENTATIONS[orientation];
+        const std::size_t anchor = Geometry::index_of(x, y);
+        const PieceOffsets &piece = PIECE_OFFSETS[orientation];
+        for(unsigned short i = 0; i < piece.cell_size; i++) {
+            _owners[anchor + piece.cells[i]] = 1u << player;
+            _values[anchor + piece.cells[i]] = field_value;
+            _state.boards[player].set((x + block.cells[i].x) * FIELD_WIDTH +
+                                      y + block.cells[i].y);
+        }
+        update_hash(x, y, orientation, player);
+        assert(!_state.is_used(player, block.block));
+        _state.remaining[player] &= ~(1u << block.block);
+        _state.turn = current_turn;
+        _state.player = (player + 1) % PLAYER_SIZE;
+        if constexpr (rule_passes<Rules>()) {
+            _passed_marks.push_back(_state.passed);
+        }
+    }
+
+    /// @brief 座標 (x, y) を左上とするブロックを除去可能か判断する.
+    /// フィールドからはみ出したマスは番兵の値になるので, 範囲は調べない
+    bool is_able_to_remove(unsigned short x, unsigned short y,
+                           unsigned short orientation) const {
+        assert(x < FIELD_WIDTH and y < FIELD_WIDTH);
+        const std::size_t anchor = Geometry::index_of(x, y);
+        const PieceOffsets &piece = PIECE_OFFSETS[orientation];
+        const short field_value = _values[anchor + piece.cells[0]];
+        for(unsigned short i = 0; i < piece.cell_size; i++) {
+            if(_values[anchor + piece.cells[i]] != field_value) {
+                return false;
+            }
+        }
+        return field_value > 0;
+    }
+
+    /// @brief 座標 (x, y) を左上とするブロックを除去する.
+    /// 最後に置いたブロックしか取り除けない
+    void remove(unsigned short x, unsigned short y,
+                unsigned short orientation) {
+        assert(is_able_to_remove(x, y, orientation));
+        TELEMETRY_TIMER(TIMER_REMOVE);
+        const Orientation &block = ORIENTATIONS[orientation];
+        const std::size_t anchor = Geometry::index_of(x, y);
+        const PieceOffsets &piece = PIECE_OFFSETS[orientation];
+        const Player player =
+            static_cast<Player>(_values[anchor + piece.cells[0]] & 0b11);
+        assert((_values[anchor + piece.cells[0]] >> 2) == current_turn);
+        for(unsigned short i = 0; i < piece.cell_size; i++) {
+            _owners[anchor + piece.cells[i]] = 0;
+            _values[anchor + piece.cells[i]] = 0;
+            _state.boards[player].reset((x + block.cells[i].x) * FIELD_WIDTH +
+                                        y + block.cells[i].y);
+        }
+        update_hash(x, y, orientation, player);
+        if constexpr (rule_passes<Rules>()) {
+            _state.passed = _passed_marks.back();
+            _passed_marks.pop_back();
+        }
+        _state.remaining[player] |= 1u << block.block;
+        current_turn--;
+        _state.turn = current_turn;
+        _state.player = player;
+    }
+
+    /// @brief フィールドの値を BasicField::save_to_file と同じ形式で
+    /// 指定したファイルパスに出力する
+    void save_to_file(const std::string &file_path) const {
+        std::ofstream file(file_path);
+        if(!file) {
+            throw std::runtime_error("Failed to open file: " + file_path);
+        }
+        write(file);
+    }
+
+    /// @brief フィールドの値を save_to_file と同じ形式で stream に出力する
+    void write(std::ostream &stream) const {
+        for(std::size_t x = 0; x < FIELD_WIDTH; x++) {
+            for(std::size_t y = 0; y < FIELD_WIDTH; y++) {
+                stream << _values[Geometry::index_of(x, y)] << ' ';
+            }
+            stream << '\n';
+        }
+    }
+
+    void show() const {
+        for(std::size_t x = 0; x < FIELD_WIDTH; x++) {
+            for(std::size_t y = 0; y < FIELD_WIDTH; y++) {
+                const short cell = _values[Geometry::index_of(x, y)];
+                std::cerr << std::setw(2) << std::setfill('0') << (cell & 0b11)
+                          << "," << std::setw(3) << std::setfill('0')
+                          << (cell >> 2) << " ";
+            }
+            std::cerr << std::endl;
+        }
+        std::cerr << std::endl;
+    }
+};
+
+/// @brief 通常のブロックスのメールボックスのフィールド
+using MailboxField = BasicMailboxField<ClassicRules>;
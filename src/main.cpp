@@ -1,7 +1,463 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "aggregate.hpp"
+#include "estimator.hpp"
+#include "frontier_search.hpp"
+#include "parallel_solver.hpp"
 #include "players.hpp"
+#include "rules.hpp"
+#include "shard.hpp"
 #include "solver.hpp"
+#include "subtree_cache.hpp"
+#include "symmetry.hpp"
+#include "telemetry.hpp"
+#include "transposition_table.hpp"
+
+/// @brief 探索の集計 (ノード数と完全なゲームの数) を標準出力へ書き出す
+void print_stats(const SearchStats &stats) {
+    std::cout << "total_steps " << stats.total_steps << '\n';
+    std::cout << "complete_games " << stats.complete_games << '\n';
+}
+
+/// @brief 置換表を使った探索の集計を, 深さごとに標準出力へ書き出す.
+/// cached ならキャッシュから引けた局面の数を, independent なら終盤の解析で
+/// 数えた局面の数も書き出す
+void print_table_stats(const TableStats &table_stats, bool cached = false,
+                       bool independent = false) {
+    for (unsigned short turn = 0; turn <= MAX_TURN; turn++) {
+        if (table_stats.expanded[turn] == 0 and table_stats.hits[turn] == 0 and
+            table_stats.cached[turn] == 0 and
+            table_stats.independent[turn] == 0) {
+            continue;
+        }
+        std::cout << "depth " << turn << " distinct "
+                  << table_stats.expanded[turn] << " hits "
+                  << table_stats.hits[turn];
+        if (cached) {
+            std::cout << " cached " << table_stats.cached[turn];
+        }
+        if (independent) {
+            std::cout << " independent " << table_stats.independent[turn];
+        }
+        std::cout << '\n';
+    }
+}
+
+/// @brief 探索木の大きさの推定値を, 深さごとに標準出力へ書き出す.
+/// 値は "推定値 信頼区間の半幅" の順
+void print_estimate(const TreeEstimate &estimate) {
+    std::cout << "probes " << estimate.probes << '\n';
+    std::cout << "total_steps " << estimate.total_steps << ' '
+              << estimate.total_steps_error << '\n';
+    std::cout << "complete_games " << estimate.complete_games << ' '
+              << estimate.complete_games_error << '\n';
+    for (unsigned short turn = 1; turn <= MAX_TURN; turn++) {
+        if (estimate.nodes[turn] == 0) {
+            continue;
+        }
+        std::cout << "depth " << turn << ' ' << estimate.nodes[turn] << ' '
+                  << estimate.nodes_error[turn] << '\n';
+    }
+}
+
+/// @brief aggregates があれば path に書き出す
+template <class Rules>
+int write_aggregates(
+    const std::optional<BasicGameAggregates<Rules>> &aggregates,
+    const std::string &path) {
+    if (!aggregates) {
+        return 0;
+    }
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        return 1;
+    }
+    aggregates->write(file);
+    return 0;
+}
+
+/// @brief コマンドライン引数で指定する設定 (各項目は main を参照)
+struct Options {
+    unsigned short thread_size = 1;
+    unsigned short split_depth = 2;
+    unsigned short prefix_depth = 2;
+    std::optional<ShardSelection> shard;
+    std::string shard_name;
+    std::string shard_file;
+    std::string checkpoint_path = "../output/checkpoint";
+    unsigned long long checkpoint_interval = 0;
+    bool resume = false;
+    std::string output_path;
+    bool save_positions = true;
+    std::string aggregate_path;
+    AggregateOptions aggregate_options;
+    std::size_t table_size = 0;
+    std::string cache_path;
+    std::size_t cache_size = 1024;
+    unsigned long long cache_min_steps = 100000;
+    unsigned short endgame_turn = 0;
+    unsigned short count_depth = 0;
+    unsigned short bfs_depth = 0;
+    FrontierOptions frontier_options;
+    std::string telemetry_path;
+    double telemetry_interval = 10;
+    unsigned long long estimate_probes = 0;
+    unsigned long long eta_probes = 0;
+    unsigned short symmetry_depth = 0;
+    EstimateOptions estimate_options;
+};
 
-int main() {
-    Solver solver;
+/// @brief ルール Rules で options の処理を行う
+template <class Rules>
+int run(Options options) {
+    // シャードのプレフィックスの番号は通常のルールの探索木で付けている
+    if (options.shard and !std::is_same_v<Rules, ClassicRules>) {
+        std::cerr << "Shards are supported only with --rules classic"
+                     " without --pass"
+                  << std::endl;
+        return 1;
+    }
+    if (options.count_depth != 0) {
+        BasicSolver<Rules> solver;
+        const std::vector<unsigned long long> counts =
+            solver.count({}, options.count_depth);
+        for (std::size_t depth = 1; depth < counts.size(); depth++) {
+            std::cout << "depth " << depth << ' ' << counts[depth] << '\n';
+        }
+        return 0;
+    }
+    if (options.bfs_depth != 0) {
+        options.frontier_options.thread_size = options.thread_size;
+        for (const FrontierLevel &level :
+             BasicFrontierSearch<Rules>(options.frontier_options)
+                 .search({}, options.bfs_depth)) {
+            std::cout << "depth " << level.depth << " distinct "
+                      << level.distinct << " nodes " << level.nodes
+                      << " complete_games " << level.complete_games
+                      << " distinct_complete_games "
+                      << level.distinct_complete_games << std::endl;
+        }
+        return 0;
+    }
+
+    options.estimate_options.thread_size = options.thread_size;
+    if (options.estimate_probes != 0) {
+        options.estimate_options.probes = options.estimate_probes;
+        print_estimate(
+            BasicTreeEstimator<Rules>(options.estimate_options).estimate({{}}));
+        return 0;
+    }
+
+    if (options.shard and options.shard_file.empty()) {
+        options.shard_file = "../output/" + options.shard_name;
+    }
+    if (options.output_path.empty()) {
+        options.output_path = options.shard
+                                  ? "../output/results-" + options.shard_name
+                                  : "../output/results";
+    }
+
+    std::unique_ptr<TranspositionTable> table;
+    if (options.table_size != 0) {
+        table = std::make_unique<TranspositionTable>(options.table_size);
+    }
+    std::unique_ptr<SubtreeCache> cache;
+    if (!options.cache_path.empty()) {
+        cache = std::make_unique<SubtreeCache>(
+            options.cache_path, options.cache_size,
+            subtree_cache_fingerprint<Rules>(), options.cache_min_steps);
+    }
+    std::unique_ptr<TelemetryLog> telemetry;
+    if (!options.telemetry_path.empty()) {
+        telemetry = std::make_unique<TelemetryLog>(
+            options.telemetry_path, options.telemetry_interval);
+    }
+    if (options.eta_probes != 0) {
+        if (!telemetry) {
+            std::cerr << "--eta-probes requires --telemetry" << std::endl;
+            return 1;
+        }
+        // シャードなら担当するプレフィックスの部分木だけを推定する
+        std::vector<std::vector<Move>> roots = {{}};
+        if (options.shard) {
+            roots = shard_prefixes(*options.shard, options.prefix_depth);
+        }
+        options.estimate_options.probes = options.eta_probes;
+        telemetry->set_estimated_nodes(
+            BasicTreeEstimator<Rules>(options.estimate_options)
+                .estimate(roots)
+                .total_steps);
+    }
+
+    if (options.endgame_turn != 0 and
+        (options.shard or options.symmetry_depth != 0)) {
+        std::cerr << "--endgame cannot be combined with shards or "
+                     "--symmetry-depth"
+                  << std::endl;
+        return 1;
+    }
+    if (!options.aggregate_path.empty() and
+        (table or cache or options.endgame_turn != 0 or options.resume)) {
+        std::cerr << "--aggregate cannot be combined with --tt-size, --cache, "
+                     "--endgame or --resume"
+                  << std::endl;
+        return 1;
+    }
+    if ((!options.aggregate_path.empty() or !options.save_positions) and
+        (options.shard or options.symmetry_depth != 0)) {
+        std::cerr << "--aggregate and --no-positions cannot be combined with "
+                     "shards or --symmetry-depth"
+                  << std::endl;
+        return 1;
+    }
+    std::optional<BasicGameAggregates<Rules>> aggregates;
+    if (!options.aggregate_path.empty()) {
+        aggregates.emplace(options.aggregate_options);
+    }
+    if (options.symmetry_depth != 0) {
+        if (options.shard or options.resume or
+            options.checkpoint_interval != 0) {
+            std::cerr << "--symmetry-depth cannot be combined with shards or "
+                         "checkpoints"
+                      << std::endl;
+            return 1;
+        }
+        std::cout << "symmetries " << tree_symmetries<Rules>().size() << '\n';
+        const SearchStats stats = solve_symmetric<Rules>(
+            options.symmetry_depth, options.thread_size, options.split_depth,
+            options.output_path, table.get(), telemetry.get(), cache.get());
+        print_stats(stats);
+        return 0;
+    }
+    if (options.shard) {
+        const ShardResult result = solve_shard(
+            *options.shard, options.prefix_depth, options.thread_size,
+            options.split_depth, options.output_path, table.get(),
+            telemetry.get(), cache.get());
+        std::ofstream file(options.shard_file);
+        if (!file) {
+            std::cerr << "Failed to open file: " << options.shard_file
+                      << std::endl;
+            return 1;
+        }
+        result.write(file);
+        return 0;
+    }
+    if (options.thread_size <= 1) {
+        BasicSolver<Rules> solver;
+        std::optional<Checkpoint> checkpoint;
+        if (options.resume) {
+            checkpoint = Checkpoint::load(options.checkpoint_path,
+                                          rule_fingerprint<Rules>());
+        }
+        std::optional<ResultWriter> writer;
+        if (options.save_positions) {
+            // チェックポイントより後に書いた局面は, 再開後にもう一度書く
+            if (checkpoint and checkpoint->output_offset != 0) {
+                writer.emplace(options.output_path, rule_fingerprint<Rules>(),
+                               checkpoint->output_offset);
+            } else {
+                writer.emplace(options.output_path, rule_fingerprint<Rules>());
+            }
+            solver.set_output(&*writer);
+        }
+        solver.set_save_positions(options.save_positions);
+        solver.set_aggregates(aggregates ? &*aggregates : nullptr);
+        solver.set_checkpoint(options.checkpoint_path,
+                              options.checkpoint_interval);
+        solver.set_transposition_table(table.get());
+        solver.set_telemetry(telemetry.get());
+        solver.set_subtree_cache(cache.get());
+        solver.set_endgame_turn(options.endgame_turn);
+        if (checkpoint) {
+            solver.resume(*checkpoint);
+        } else {
+            solver.solve();
+        }
+        print_stats(solver.stats());
+        if (table or cache or options.endgame_turn != 0) {
+            print_table_stats(solver.table_stats(), cache != nullptr,
+                              options.endgame_turn != 0);
+        }
+        return write_aggregates(aggregates, options.aggregate_path);
+    }
+    if (options.resume or options.checkpoint_interval != 0) {
+        std::cerr << "Checkpoints are supported only with --threads 1"
+                  << std::endl;
+        return 1;
+    }
+    BasicParallelSolver<Rules> solver(options.thread_size,
+                                      options.split_depth,
+                                      options.output_path, table.get());
+    solver.set_telemetry(telemetry.get());
+    solver.set_subtree_cache(cache.get());
+    solver.set_endgame_turn(options.endgame_turn);
+    solver.set_save_positions(options.save_positions);
+    solver.set_aggregates(aggregates ? &*aggregates : nullptr);
     solver.solve();
+    print_stats(solver.stats());
+    if (table or cache or options.endgame_turn != 0) {
+        print_table_stats(solver.table_stats(), cache != nullptr,
+                          options.endgame_turn != 0);
+    }
+    return write_aggregates(aggregates, options.aggregate_path);
+}
+
+/// @brief passing ならルール Base に合法手の無いプレイヤーのパスを加えて
+/// run を呼ぶ
+template <class Base>
+int run_rules(const Options &options, bool passing) {
+    if (passing) {
+        return run<WithPassing<Base>>(options);
+    }
+    return run<Base>(options);
+}
+
+int main(int argc, char *argv[]) {
+    // --rules NAME: 探索するルール. classic (通常のブロックス, 既定),
+    //   duo (14 x 14 の 2 人用), mini (6 x 6 の向かい合う角から 2 人で
+    //   小さい方から 4 個のブロックを使う, 全探索できる大きさ)
+    // --pass: 合法手の無いプレイヤーはパスし, 全員がパスするまで探索する
+    // --threads N: N スレッドで探索する
+    // --split-depth D: 並列探索で D 手目以降を部分木としてスレッドに配る
+    // --shard i/N: prefix-depth 手目までのプレフィックスのうち,
+    //   番号を N で割った余りが i のものだけを探索する
+    // --prefixes a,b,c: 番号 a, b, c のプレフィックスだけを探索する
+    // --prefix-depth K: シャードに分けるプレフィックスの手数
+    // --shard-file PATH: シャードの集計結果の出力先
+    // --checkpoint PATH: 探索の途中経過の出力先 (1 スレッドの探索のみ)
+    // --checkpoint-interval N: ブロックを N 回置くごとに途中経過を書き出す
+    // --resume: --checkpoint の途中経過から探索を再開する
+    // --output PATH: 局面の出力先 (並列探索ではスレッドごとに PATH-t<番号>)
+    // --no-positions: 局面を書き出さない
+    // --aggregate PATH: 探索しながら終局した局面のマスの埋まり方, 残った
+    //   ブロック, ターンごとに置いた向きを数え, 終了時に PATH へ書き出す
+    // --aggregate-kinds LIST: --aggregate で数える種類をカンマ区切りで選ぶ
+    //   (occupancy, remaining, usage. 既定ではすべて)
+    // --telemetry PATH: 探索の計測値を JSON Lines で PATH に追記する
+    // --telemetry-interval S: 計測値を書き出す間隔 (秒)
+    // --count-depth D: 初手から D 手目までの手数ごとの局面の数を出力する.
+    //   局面は出力しない
+    // --bfs D: 初手から D 手目まで幅優先で展開し, 手数ごとの相異なる局面の
+    //   数を出力する. 各手数の局面はディスク上でソートして重複を除く
+    // --bfs-dir PATH: 幅優先探索の局面のファイルを置くディレクトリ
+    // --bfs-memory MB: 幅優先探索で局面をソートするバッファの大きさ (MiB)
+    // --tt-size MB: MB MiB の置換表で同じ局面の部分木の探索を省く.
+    //   終了時に深さごとの相異なる局面の数を出力する
+    // --cache PATH: 部分木の集計を PATH のファイルに残し, 前の実行や
+    //   同時に動く別のシャードが探索した部分木を探索せずに集計だけ足す
+    // --cache-size MB: --cache のファイルを作るときの大きさ (MiB)
+    // --cache-min-steps N: ノード数が N 以上の部分木だけを --cache に残す
+    // --endgame T: T 手目以降の局面で, 各プレイヤーの置きうるマスが互いに
+    //   重ならなくなったら, プレイヤーごとの手順の数から部分木を数える.
+    //   終了時に深さごとのそうして数えた局面の数を出力する
+    // --estimate N: 探索せず, N 回の Knuth の推定で探索木の大きさを出力する
+    // --estimate-stratify D: D 手目までは数え上げ, その先は局面ごとに
+    //   層を分けて推定する
+    // --estimate-weighted: マスの多いブロックの手ほど選びやすくして推定する
+    // --estimate-seed S: 推定に使う乱数の種
+    // --symmetry-depth K: K 手目までの手順をフィールドの対称変換で移り合う
+    //   ものに分け, 代表だけを探索して集計を軌道の大きさ倍する
+    // --eta-probes N: 探索の前に N 回の推定で部分木の大きさを求め,
+    //   計測値と一緒に残り時間を書き出す (--telemetry が必要)
+    Options options;
+    std::string rules = "classic";
+    bool passing = false;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" and i + 1 < argc) {
+            options.thread_size = std::stoi(argv[++i]);
+        } else if (arg == "--split-depth" and i + 1 < argc) {
+            options.split_depth = std::stoi(argv[++i]);
+        } else if (arg == "--shard" and i + 1 < argc) {
+            options.shard = ShardSelection::parse_shard(argv[++i]);
+            options.shard_name = "shard-" +
+                                 std::to_string(options.shard->index) +
+                                 "-of-" + std::to_string(options.shard->count);
+        } else if (arg == "--prefixes" and i + 1 < argc) {
+            options.shard = ShardSelection::parse_prefixes(argv[++i]);
+            options.shard_name = "shard-prefixes";
+        } else if (arg == "--prefix-depth" and i + 1 < argc) {
+            options.prefix_depth = std::stoi(argv[++i]);
+        } else if (arg == "--shard-file" and i + 1 < argc) {
+            options.shard_file = argv[++i];
+        } else if (arg == "--checkpoint" and i + 1 < argc) {
+            options.checkpoint_path = argv[++i];
+            if (options.checkpoint_interval == 0) {
+                options.checkpoint_interval = 100000000;
+            }
+        } else if (arg == "--checkpoint-interval" and i + 1 < argc) {
+            options.checkpoint_interval = std::stoull(argv[++i]);
+        } else if (arg == "--resume") {
+            options.resume = true;
+        } else if (arg == "--output" and i + 1 < argc) {
+            options.output_path = argv[++i];
+        } else if (arg == "--no-positions") {
+            options.save_positions = false;
+        } else if (arg == "--aggregate" and i + 1 < argc) {
+            options.aggregate_path = argv[++i];
+        } else if (arg == "--aggregate-kinds" and i + 1 < argc) {
+            options.aggregate_options = AggregateOptions::parse(argv[++i]);
+        } else if (arg == "--telemetry" and i + 1 < argc) {
+            options.telemetry_path = argv[++i];
+        } else if (arg == "--telemetry-interval" and i + 1 < argc) {
+            options.telemetry_interval = std::stod(argv[++i]);
+        } else if (arg == "--count-depth" and i + 1 < argc) {
+            options.count_depth = std::stoi(argv[++i]);
+        } else if (arg == "--bfs" and i + 1 < argc) {
+            options.bfs_depth = std::stoi(argv[++i]);
+        } else if (arg == "--bfs-dir" and i + 1 < argc) {
+            options.frontier_options.directory = argv[++i];
+        } else if (arg == "--bfs-memory" and i + 1 < argc) {
+            options.frontier_options.memory_size = std::stoull(argv[++i])
+                                                   << 20;
+        } else if (arg == "--tt-size" and i + 1 < argc) {
+            options.table_size = std::stoul(argv[++i]);
+        } else if (arg == "--cache" and i + 1 < argc) {
+            options.cache_path = argv[++i];
+        } else if (arg == "--cache-size" and i + 1 < argc) {
+            options.cache_size = std::stoul(argv[++i]);
+        } else if (arg == "--cache-min-steps" and i + 1 < argc) {
+            options.cache_min_steps = std::stoull(argv[++i]);
+        } else if (arg == "--endgame" and i + 1 < argc) {
+            options.endgame_turn = std::stoi(argv[++i]);
+        } else if (arg == "--estimate" and i + 1 < argc) {
+            options.estimate_probes = std::stoull(argv[++i]);
+        } else if (arg == "--estimate-stratify" and i + 1 < argc) {
+            options.estimate_options.stratify_depth = std::stoi(argv[++i]);
+        } else if (arg == "--estimate-weighted") {
+            options.estimate_options.weighted = true;
+        } else if (arg == "--estimate-seed" and i + 1 < argc) {
+            options.estimate_options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--symmetry-depth" and i + 1 < argc) {
+            options.symmetry_depth = std::stoi(argv[++i]);
+        } else if (arg == "--eta-probes" and i + 1 < argc) {
+            options.eta_probes = std::stoull(argv[++i]);
+        } else if (arg == "--rules" and i + 1 < argc) {
+            rules = argv[++i];
+        } else if (arg == "--pass") {
+            passing = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (rules == "classic") {
+        return run_rules<ClassicRules>(options, passing);
+    }
+    if (rules == "duo") {
+        return run_rules<DuoRules>(options, passing);
+    }
+    if (rules == "mini") {
+        return run_rules<MiniRules>(options, passing);
+    }
+    std::cerr << "Unknown rules: " << rules << std::endl;
+    return 1;
 }
@@ -0,0 +1,70 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "shard.hpp"
+
+/// @brief シャードごとの集計ファイルを合わせて全体の集計を出力する.
+/// すべてのプレフィックスがちょうど 1 回ずつ探索されていることを確かめる
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " SHARD_FILE..." << std::endl;
+        return 1;
+    }
+
+    std::vector<ShardResult> results;
+    for (int i = 1; i < argc; i++) {
+        std::ifstream file(argv[i]);
+        if (!file) {
+            std::cerr << "Failed to open file: " << argv[i] << std::endl;
+            return 1;
+        }
+        results.push_back(ShardResult::read(file));
+    }
+
+    // プレフィックスの列挙はどのシャードでも同じはずなので, 先頭と比べる
+    const ShardResult &first = results.front();
+    bool ok = true;
+    for (int i = 0; i < static_cast<int>(results.size()); i++) {
+        const ShardResult &result = results[i];
+        if (result.prefix_depth != first.prefix_depth or
+            result.prefix_count != first.prefix_count or
+            result.trunk.total_steps != first.trunk.total_steps or
+            result.trunk.complete_games != first.trunk.complete_games) {
+            std::cerr << "Header mismatch: " << argv[i + 1] << std::endl;
+            ok = false;
+        }
+    }
+
+    // covered[i] := プレフィックス i を探索したシャードの数
+    std::vector<unsigned> covered(first.prefix_count, 0);
+    SearchStats total = first.trunk;
+    for (const ShardResult &result : results) {
+        for (const auto &[index, stats] : result.prefixes) {
+            if (index >= covered.size()) {
+                std::cerr << "Prefix index out of range: " << index
+                          << std::endl;
+                ok = false;
+                continue;
+            }
+            covered[index]++;
+            total += stats;
+        }
+    }
+    for (std::size_t index = 0; index < covered.size(); index++) {
+        if (covered[index] == 0) {
+            std::cerr << "Missing prefix: " << index << std::endl;
+            ok = false;
+        } else if (covered[index] > 1) {
+            std::cerr << "Prefix covered " << covered[index]
+                      << " times: " << index << std::endl;
+            ok = false;
+        }
+    }
+    if (!ok) {
+        return 1;
+    }
+
+    std::cout << "total_steps " << total.total_steps << '\n';
+    std::cout << "complete_games " << total.complete_games << std::endl;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "position.hpp"
+
+/// @brief ブロックの配置 1 つを表す.
+/// ORIENTATIONS[orientation] の向きのブロックを, position
+/// を左上として置くことを表す
+struct Move {
+    unsigned short orientation;
+    Position position;
+    Move() : orientation(0), position() {}
+    Move(unsigned short orientation_, Position position_)
+        : orientation(orientation_), position(position_) {}
+};
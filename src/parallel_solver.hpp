@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma once
+#include "move.hpp"
+#include "result_stream.hpp"
+#include "solver.hpp"
+
+/// @brief 部分木 (= 初手からの手順) を積むキュー. 持ち主のスレッドは末尾から,
+/// 他のスレッドは先頭から取り出す
+class WorkStealingQueue {
+    std::deque<std::vector<Move>> _tasks;
+    std::mutex _mutex;
+
+   public:
+    void push(std::vector<Move> task) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+
+    /// @brief 持ち主のスレッドが末尾からタスクを取り出す
+    bool pop(std::vector<Move> &task) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_tasks.empty()) {
+            return false;
+        }
+        task = std::move(_tasks.back());
+        _tasks.pop_back();
+        return true;
+    }
+
+    /// @brief 他のスレッドが先頭からタスクを盗む
+    bool steal(std::vector<Move> &task) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_tasks.empty()) {
+            return false;
+        }
+        task = std::move(_tasks.front());
+        _tasks.pop_front();
+        return true;
+    }
+};
+
+/// @brief ルール Rules の探索木を split_depth 手目で部分木に分け, thread_size
+/// 個のスレッドで並列に探索する. 各スレッドは自分の Solver (Field
+/// のコピー) を持ち, 集計結果と出力はスレッドごとに分けてから合わせる.
+/// 局面はスレッドごとに output_path-t<番号> へ ResultWriter で書き出す.
+/// split_depth 手目までに終わった局面は, 分ける前に output_path-split
+/// (set_split_output で渡したものがあればそれ) へ書き出す.
+/// table を渡すと, すべてのスレッドでその置換表を共有する
+template <class Rules>
+class BasicParallelSolver {
+    using Solver = BasicSolver<Rules>;
+
+    unsigned short _thread_size;
+    unsigned short _split_depth;
+    std::string _output_path;
+    TranspositionTable *_table;
+    TelemetryLog *_telemetry = nullptr;
+    SubtreeCache *_cache = nullptr;
+    unsigned short _endgame_turn = 0;
+    bool _save_positions = true;
+    ResultWriter *_split_output = nullptr;
+    BasicGameAggregates<Rules> *_aggregates = nullptr;
+    SearchStats _stats;
+    TableStats _table_stats;
+
+   public:
+    BasicParallelSolver(unsigned short thread_size, unsigned short split_depth,
+                        const std::string &output_path = "../output/results",
+                        TranspositionTable *table = nullptr)
+        : _thread_size(std::max<unsigned short>(thread_size, 1)),
+          _split_depth(split_depth),
+          _output_path(output_path),
+          _table(table) {}
+
+    void solve() { solve({}); }
+
+    /// @brief root を置いた局面以下を並列に探索する
+    void solve(const std::vector<Move> &root) {
+        // split_depth 手先までは 1 スレッドで展開する
+        Solver splitter;
+        std::optional<ResultWriter> split_writer;
+        if (_save_positions and _split_output != nullptr) {
+            splitter.set_output(_split_output);
+        } else if (_save_positions) {
+            split_writer.emplace(_output_path + "-split",
+                                 rule_fingerprint<Rules>());
+            splitter.set_output(&*split_writer);
+        }
+        splitter.set_save_positions(_save_positions);
+        splitter.set_aggregates(_aggregates);
+        std::vector<std::vector<Move>> prefixes;
+        splitter.split(root, _split_depth, prefixes);
+        if (split_writer) {
+            split_writer->close();
+        }
+
+        // 部分木をスレッドに順に配る. 偏りはスレッド間の steal でならす
+        std::vector<WorkStealingQueue> queues(_thread_size);
+        for (std::size_t i = 0; i < prefixes.size(); i++) {
+            queues[i % _thread_size].push(std::move(prefixes[i]));
+        }
+
+        std::vector<SearchStats> worker_stats(_thread_size);
+        std::vector<TableStats> worker_table_stats(_thread_size);
+        // 各スレッドの集計. 集計しないなら空のまま
+        std::vector<BasicGameAggregates<Rules>> worker_aggregates;
+        if (_aggregates != nullptr) {
+            const BasicGameAggregates<Rules> empty(_aggregates->options());
+            worker_aggregates.assign(_thread_size, empty);
+        }
+        std::vector<std::thread> workers;
+        for (unsigned short worker = 0; worker < _thread_size; worker++) {
+            workers.emplace_back(
+                [this, worker, &queues, &worker_stats, &worker_table_stats,
+                 &worker_aggregates] {
+                    work(worker, queues, worker_stats[worker],
+                         worker_table_stats[worker],
+                         worker_aggregates.empty()
+                             ? nullptr
+                             : &worker_aggregates[worker]);
+                });
+        }
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+
+        _stats = splitter.stats();
+        for (const SearchStats &stats : worker_stats) {
+            _stats += stats;
+        }
+        _table_stats = TableStats{};
+        for (const TableStats &stats : worker_table_stats) {
+            _table_stats += stats;
+        }
+        for (const BasicGameAggregates<Rules> &aggregates : worker_aggregates) {
+            *_aggregates += aggregates;
+        }
+    }
+
+    /// @brief 各スレッドの計測値を telemetry に報告する
+    void set_telemetry(TelemetryLog *telemetry) { _telemetry = telemetry; }
+
+    /// @brief すべてのスレッドで cache を共有する (Solver::set_subtree_cache)
+    void set_subtree_cache(SubtreeCache *cache) { _cache = cache; }
+
+    /// @brief すべてのスレッドで終盤の解析を使う (Solver::set_endgame_turn)
+    void set_endgame_turn(unsigned short turn) { _endgame_turn = turn; }
+
+    /// @brief false にすると局面を書き出さず, スレッドごとのファイルも作らない
+    void set_save_positions(bool save) { _save_positions = save; }
+
+    /// @brief split_depth 手目までに終わった局面を, output_path-split を
+    /// 開く代わりに output に書き出す. output は呼び出し側が閉じる
+    void set_split_output(ResultWriter *output) { _split_output = output; }
+
+    /// @brief スレッドごとに数えた集計を, 探索の終わりに aggregates に足す.
+    /// split_depth 手目までの展開の分は aggregates に直接数える
+    void set_aggregates(BasicGameAggregates<Rules> *aggregates) {
+        _aggregates = aggregates;
+    }
+
+    const SearchStats &stats() const { return _stats; }
+    const TableStats &table_stats() const { return _table_stats; }
+
+   private:
+    /// @brief スレッド worker の処理. 自分のキューが空になったら,
+    /// 他のスレッドのキューから盗む. タスクは途中で増えないので,
+    /// すべてのキューが空になれば終了する
+    void work(unsigned short worker, std::vector<WorkStealingQueue> &queues,
+              SearchStats &stats, TableStats &table_stats,
+              BasicGameAggregates<Rules> *aggregates) {
+        Solver solver;
+        std::optional<ResultWriter> writer;
+        if (_save_positions) {
+            writer.emplace(_output_path + "-t" + std::to_string(worker),
+                           rule_fingerprint<Rules>());
+            solver.set_output(&*writer);
+        }
+        solver.set_save_positions(_save_positions);
+        solver.set_aggregates(aggregates);
+        solver.set_transposition_table(_table);
+        solver.set_telemetry(_telemetry);
+        solver.set_subtree_cache(_cache);
+        solver.set_endgame_turn(_endgame_turn);
+
+        std::vector<Move> task;
+        while (true) {
+            bool found = queues[worker].pop(task);
+            for (unsigned short i = 1; !found and i < _thread_size; i++) {
+                found = queues[(worker + i) % _thread_size].steal(task);
+            }
+            if (!found) {
+                break;
+            }
+            solver.solve(task);
+        }
+        if (writer) {
+            writer->close();
+        }
+        stats = solver.stats();
+        table_stats = solver.table_stats();
+    }
+};
+
+using ParallelSolver = BasicParallelSolver<ClassicRules>;
@@ -0,0 +1,246 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iostream>
+
+#include "position.hpp"
+
+// ブロックの種類数
+constexpr unsigned short BLOCK_SIZE = 21;
+// 1 つのブロックを構成するマスの最大数
+constexpr std::size_t MAX_BLOCK_CELL_SIZE = 5;
+// 回転と裏返しの組み合わせの数
+constexpr unsigned short BLOCK_MODE_SIZE = 8;
+
+/// @brief ブロックの 1 つの向き (回転, 裏返し込み) を表す.
+/// マスの座標はバウンディングボックスの左上を原点とし, (x, y) の辞書順に並ぶ
+struct Orientation {
+    // ブロックの種類 (0 ~ BLOCK_SIZE - 1)
+    unsigned short block = 0;
+    unsigned short cell_size = 0;
+    std::array<Position, MAX_BLOCK_CELL_SIZE> cells{};
+    unsigned short height = 0, width = 0;
+
+    friend constexpr bool operator==(const Orientation &lhs,
+                                     const Orientation &rhs) {
+        if(lhs.cell_size != rhs.cell_size) {
+            return false;
+        }
+        for(unsigned short i = 0; i < lhs.cell_size; i++) {
+            if(lhs.cells[i].x != rhs.cells[i].x or
+               lhs.cells[i].y != rhs.cells[i].y) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/// @brief '#' をマス, それ以外を空白とする width 列の図からブロックを作る
+constexpr Orientation make_block_shape(const char *picture,
+                                       unsigned short width) {
+    Orientation shape;
+    for(unsigned short i = 0; picture[i] != '\0'; i++) {
+        if(picture[i] == '#') {
+            shape.cells[shape.cell_size++] = Position(i / width, i % width);
+        }
+    }
+    return shape;
+}
+
+// 各ブロックの基本形. 並びはブロックの番号と一致する
+constexpr std::array<Orientation, BLOCK_SIZE> BLOCK_SHAPES = {
+    // monomino
+    make_block_shape("#", 1),
+    // domino
+    make_block_shape("#"
+                     "#",
+                     1),
+    // tromino_i
+    make_block_shape("#"
+                     "#"
+                     "#",
+                     1),
+    // tromino_l
+    make_block_shape("#."
+                     "##",
+                     2),
+    // tetromino_straight
+    make_block_shape("####", 4),
+    // tetromino_square
+    make_block_shape("##"
+                     "##",
+                     2),
+    // tetromino_t
+    make_block_shape("###"
+                     ".#.",
+                     3),
+    // tetromino_l
+    make_block_shape("#."
+                     "#."
+                     "##",
+                     2),
+    // tetromino_skew
+    make_block_shape(".##"
+                     "##.",
+                     3),
+    // pentomino_f
+    make_block_shape(".##"
+                     "##."
+                     ".#.",
+                     3),
+    // pentomino_i
+    make_block_shape("#"
+                     "#"
+                     "#"
+                     "#"
+                     "#",
+                     1),
+    // pentomino_l
+    make_block_shape("#."
+                     "#."
+                     "#."
+                     "##",
+                     2),
+    // pentomino_n
+    make_block_shape(".#"
+                     ".#"
+                     "##"
+                     "#.",
+                     2),
+    // pentomino_p
+    make_block_shape("##"
+                     "##"
+                     "#.",
+                     2),
+    // pentomino_t
+    make_block_shape("###"
+                     ".#."
+                     ".#.",
+                     3),
+    // pentomino_u
+    make_block_shape("#.#"
+                     "###",
+                     3),
+    // pentomino_v
+    make_block_shape("#.."
+                     "#.."
+                     "###",
+                     3),
+    // pentomino_w
+    make_block_shape("#.."
+                     "##."
+                     ".##",
+                     3),
+    // pentomino_x
+    make_block_shape(".#."
+                     "###"
+                     ".#.",
+                     3),
+    // pentomino_y
+    make_block_shape("..#."
+                     "####",
+                     4),
+    // pentomino_z
+    make_block_shape("##."
+                     ".#."
+                     ".##",
+                     3),
+};
+
+/// @brief shape を mode (0 ~ 7) に従って回転, 裏返しし,
+/// バウンディングボックスの左上が原点になるよう正規化する.
+/// mode が 4 以上のときは左右を反転してから回転する
+constexpr Orientation transform(const Orientation &shape,
+                                unsigned short mode) {
+    std::array<short, MAX_BLOCK_CELL_SIZE> xs{}, ys{};
+    for(unsigned short i = 0; i < shape.cell_size; i++) {
+        short x = shape.cells[i].x;
+        short y = shape.cells[i].y;
+        if(mode >= 4) {
+            y = -y;
+        }
+        // 90 度回転を mode % 4 回行う
+        for(unsigned short r = 0; r < mode % 4; r++) {
+            const short rotated_x = -y;
+            y = x;
+            x = rotated_x;
+        }
+        xs[i] = x;
+        ys[i] = y;
+    }
+    const short min_x = *std::min_element(xs.begin(), xs.begin() + shape.cell_size);
+    const short min_y = *std::min_element(ys.begin(), ys.begin() + shape.cell_size);
+
+    Orientation result;
+    result.block = shape.block;
+    result.cell_size = shape.cell_size;
+    for(unsigned short i = 0; i < shape.cell_size; i++) {
+        result.cells[i] = Position(xs[i] - min_x, ys[i] - min_y);
+        result.height = std::max<unsigned short>(result.height,
+                                                 result.cells[i].x + 1);
+        result.width = std::max<unsigned short>(result.width,
+                                                result.cells[i].y + 1);
+    }
+    std::sort(result.cells.begin(), result.cells.begin() + result.cell_size,
+              [](const Position &lhs, const Position &rhs) {
+                  return lhs.x != rhs.x ? lhs.x < rhs.x : lhs.y < rhs.y;
+              });
+    return result;
+}
+
+/// @brief 重複を除いた全ブロックの向きを列挙する. callback
+/// に各向きを順に渡し, 向きの総数を返す
+template <class F>
+constexpr std::size_t enumerate_orientations(F &&callback) {
+    std::size_t orientation_size = 0;
+    for(unsigned short block = 0; block < BLOCK_SIZE; block++) {
+        Orientation shape = BLOCK_SHAPES[block];
+        shape.block = block;
+        std::array<Orientation, BLOCK_MODE_SIZE> found{};
+        unsigned short found_size = 0;
+        for(unsigned short mode = 0; mode < BLOCK_MODE_SIZE; mode++) {
+            const Orientation orientation = transform(shape, mode);
+            if(std::find(found.begin(), found.begin() + found_size,
+                         orientation) != found.begin() + found_size) {
+                continue;
+            }
+            found[found_size++] = orientation;
+            callback(orientation);
+            orientation_size++;
+        }
+    }
+    return orientation_size;
+}
+
+// 重複を除いた向きの総数. 標準の 21 種類では 91 となる
+constexpr std::size_t ORIENTATION_SIZE =
+    enumerate_orientations([](const Orientation &) {});
+static_assert(ORIENTATION_SIZE == 91);
+
+// 重複を除いた全ブロックの向き. 同じブロックの向きは連続して並ぶ
+constexpr std::array<Orientation, ORIENTATION_SIZE> ORIENTATIONS = [] {
+    std::array<Orientation, ORIENTATION_SIZE> orientations{};
+    std::size_t index = 0;
+    enumerate_orientations([&](const Orientation &orientation) {
+        orientations[index++] = orientation;
+    });
+    return orientations;
+}();
+
+inline std::ostream &operator<<(std::ostream &stream,
+                                const Orientation &orientation) {
+    for(unsigned short x = 0; x < orientation.height; x++) {
+        for(unsigned short y = 0; y < orientation.width; y++) {
+            bool filled = false;
+            for(unsigned short i = 0; i < orientation.cell_size; i++) {
+                filled |= orientation.cells[i].x == x and
+                          orientation.cells[i].y == y;
+            }
+            stream << (filled ? '#' : '.');
+        }
+        stream << "\n";
+    }
+    return stream;
+}
@@ -1,4 +1,5 @@
 #pragma once
+// プレイヤーの数の最大値 (Player の値の数). ルールごとの数は Rules::PLAYER_SIZE
 constexpr unsigned short PLAYER_SIZE = 4;
 
 enum Player {
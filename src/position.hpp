@@ -1,5 +1,6 @@
+#pragma once
 struct Position {
     unsigned short x, y;
-    Position() : x(0), y(0) {}
-    Position(unsigned short x_, unsigned short y_) : x(x_), y(y_) {}
+    constexpr Position() : x(0), y(0) {}
+    constexpr Position(unsigned short x_, unsigned short y_) : x(x_), y(y_) {}
 };
@@ -0,0 +1,597 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma once
+#include "field.hpp"
+#include "move.hpp"
+#include "pieces.hpp"
+#include "rules.hpp"
+
+/// 探索結果 (局面) を手順として詰めて書き出すバイナリ形式.
+///
+/// ファイルはヘッダ, ブロックの並び, 索引からなる. 整数はリトルエンディアン.
+/// - ヘッダ: magic "BLKR" (4 バイト), version (4 バイト), 局面を探索した
+///   ルールの指紋 (rule_fingerprint, 8 バイト)
+/// - ブロック: magic "BLKB", レコード数 (4 バイト), 本体のバイト数 (4 バイト),
+///   先頭レコードの通し番号 (8 バイト), 本体
+/// - 索引: 各ブロックの (ファイル内の位置, 先頭レコードの通し番号) を 8
+///   バイトずつ並べたもの, ブロック数 (8 バイト), 索引の位置 (8 バイト),
+///   magic "BLKI"
+///
+/// レコードは 1 バイトの長さ (下位 7 bit が手数, 最上位 bit
+/// が途中経過の局面かどうか) と, 2 バイトずつの手からなる. 手は上位 7 bit
+/// が向き (ORIENTATIONS の添字. ブロックの種類も向きから決まる), 下位 9 bit
+/// が左上のマスの番号 x * FIELD_WIDTH + y.
+///
+/// 索引はファイルを閉じるときに書く. 索引がないファイル (途中で落ちた場合)
+/// はブロックのヘッダを辿って読み, 追記時には壊れた末尾を切り捨てる.
+namespace result_stream {
+
+constexpr std::uint32_t FILE_MAGIC = 0x524b4c42;   // "BLKR"
+constexpr std::uint32_t BLOCK_MAGIC = 0x424b4c42;  // "BLKB"
+constexpr std::uint32_t INDEX_MAGIC = 0x494b4c42;  // "BLKI"
+constexpr std::uint32_t VERSION = 2;
+constexpr std::size_t FILE_HEADER_SIZE = 16;
+constexpr std::size_t BLOCK_HEADER_SIZE = 20;
+constexpr std::size_t INDEX_TRAILER_SIZE = 20;
+// レコードの長さのバイトで, 途中経過の局面を表すビット
+constexpr std::uint8_t SNAPSHOT_FLAG = 0x80;
+
+static_assert(ORIENTATION_SIZE <= (1 << 7));
+static_assert(FIELD_CELL_SIZE <= (1 << 9));
+
+inline std::uint16_t encode_move(const Move &move) {
+    return static_cast<std::uint16_t>(
+        (move.orientation << 9) |
+        (move.position.x * FIELD_WIDTH + move.position.y));
+}
+
+inline Move decode_move(std::uint16_t code) {
+    const unsigned short cell = code & 0x1ff;
+    return Move(code >> 9, Position(cell / FIELD_WIDTH, cell % FIELD_WIDTH));
+}
+
+template <class T>
+void append_value(std::vector<std::uint8_t> &buffer, T value) {
+    const std::size_t size = buffer.size();
+    buffer.resize(size + sizeof(T));
+    std::memcpy(buffer.data() + size, &value, sizeof(T));
+}
+
+template <class T>
+void store_value(std::uint8_t *data, T value) {
+    std::memcpy(data, &value, sizeof(T));
+}
+
+template <class T>
+T load_value(const std::uint8_t *data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/// @brief ブロックの位置と先頭レコードの通し番号
+struct BlockEntry {
+    std::uint64_t offset;
+    std::uint64_t first_record;
+    std::uint32_t record_size;
+};
+
+/// @brief data (size バイト) のブロックを先頭から辿り, 完全なブロックの一覧と,
+/// 最後の完全なブロックの終端の位置を返す
+inline std::vector<BlockEntry> scan_blocks(const std::uint8_t *data,
+                                           std::size_t size,
+                                           std::size_t &end) {
+    std::vector<BlockEntry> blocks;
+    std::size_t offset = FILE_HEADER_SIZE;
+    std::uint64_t record = 0;
+    while (offset + BLOCK_HEADER_SIZE <= size and
+           load_value<std::uint32_t>(data + offset) == BLOCK_MAGIC) {
+        const auto record_size = load_value<std::uint32_t>(data + offset + 4);
+        const auto payload_size = load_value<std::uint32_t>(data + offset + 8);
+        if (offset + BLOCK_HEADER_SIZE + payload_size > size) {
+            break;
+        }
+        blocks.push_back({offset, record, record_size});
+        record += record_size;
+        offset += BLOCK_HEADER_SIZE + payload_size;
+    }
+    end = offset;
+    return blocks;
+}
+
+/// @brief ファイル fd の先頭 size バイトのブロックを, ヘッダだけを 1 つずつ
+/// pread で読んで辿る. ファイル全体を読み込まずに scan_blocks と同じ結果を返す
+inline std::vector<BlockEntry> scan_block_headers(int fd, std::uint64_t size,
+                                                  std::uint64_t &end) {
+    std::vector<BlockEntry> blocks;
+    std::uint64_t offset = FILE_HEADER_SIZE;
+    std::uint64_t record = 0;
+    std::uint8_t header[BLOCK_HEADER_SIZE];
+    while (offset + BLOCK_HEADER_SIZE <= size and
+           ::pread(fd, header, BLOCK_HEADER_SIZE, offset) ==
+               static_cast<ssize_t>(BLOCK_HEADER_SIZE) and
+           load_value<std::uint32_t>(header) == BLOCK_MAGIC) {
+        const auto record_size = load_value<std::uint32_t>(header + 4);
+        const auto payload_size = load_value<std::uint32_t>(header + 8);
+        if (offset + BLOCK_HEADER_SIZE + payload_size > size) {
+            break;
+        }
+        blocks.push_back({offset, record, record_size});
+        record += record_size;
+        offset += BLOCK_HEADER_SIZE + payload_size;
+    }
+    end = offset;
+    return blocks;
+}
+
+}  // namespace result_stream
+
+/// @brief 局面の手順を追記していくライタ. レコードはメモリに溜め,
+/// ブロック単位でまとめて 1 回の write で書き出す.
+///
+/// write は専用の I/O スレッドで行う. 探索スレッド (append を呼ぶ 1 つの
+/// スレッド) は埋まったブロックを QUEUE_SIZE 個の枠のリングバッファに渡して
+/// すぐに次の枠へ書き進め, I/O スレッドが先頭の枠から順に書き出す.
+/// 枠の受け渡しは先頭と末尾の位置の atomic だけで行い, ロックを取らない.
+/// すべての枠が書き出し待ちのときだけ, 探索スレッドは 1 つ空くまで待つ
+class ResultWriter {
+    // 1 ブロックの本体の大きさの目安
+    static constexpr std::size_t BLOCK_PAYLOAD_SIZE = 1 << 20;
+    // リングバッファの枠の数 (書き出し待ちにできるブロックの数 + 1)
+    static constexpr std::size_t QUEUE_SIZE = 8;
+    static_assert((QUEUE_SIZE & (QUEUE_SIZE - 1)) == 0);
+
+    int _fd = -1;
+    std::string _file_path;
+    std::uint32_t _pending_records = 0;
+    std::uint64_t _record_size = 0;
+    std::vector<result_stream::BlockEntry> _blocks;
+    std::uint64_t _end = 0;
+
+    // _queue[i % QUEUE_SIZE] := i 番目のブロック (ヘッダを含む).
+    // [_queue_head, _queue_tail) が書き出し待ちで, 枠 _queue_tail に
+    // 探索スレッドがレコードを追加していく. 位置は 2^32 で一周するが,
+    // QUEUE_SIZE は 2^32 を割り切るので枠の対応は変わらない.
+    // 32 bit にしておくと wait/notify が futex を直接使う
+    std::array<std::vector<std::uint8_t>, QUEUE_SIZE> _queue;
+    std::atomic<std::uint32_t> _queue_head{0};
+    std::atomic<std::uint32_t> _queue_tail{0};
+    std::atomic<bool> _closing{false};
+    // ブロックを渡したときと閉じるときに増やす. I/O スレッドはこれの変化を待つ
+    std::atomic<std::uint32_t> _wake_count{0};
+    std::thread _io_thread;
+    // I/O スレッドで起きた例外. 探索スレッドの flush, close で投げ直す
+    std::exception_ptr _error;
+    std::atomic<bool> _failed{false};
+    // 枠が空くのを待った回数
+    std::uint64_t _stall_count = 0;
+
+   public:
+    /// @brief ルールの指紋が fingerprint (rule_fingerprint) の局面を書く
+    /// file_path を開く. 既にあれば索引と壊れた末尾を取り除いて追記する.
+    /// 別のルールのファイルならエラーにする.
+    /// end を指定すると, その位置より後ろ (チェックポイントの offset() より後に
+    /// 書いたブロック) も取り除く
+    ResultWriter(const std::string &file_path, std::uint64_t fingerprint,
+                 std::uint64_t end = std::numeric_limits<std::uint64_t>::max())
+        : _file_path(file_path) {
+        using namespace result_stream;
+        _fd = ::open(file_path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (_fd < 0) {
+            throw std::runtime_error("Failed to open file: " + file_path);
+        }
+        struct stat status {};
+        ::fstat(_fd, &status);
+        if (status.st_size == 0) {
+            std::vector<std::uint8_t> header;
+            append_value(header, FILE_MAGIC);
+            append_value(header, VERSION);
+            append_value(header, fingerprint);
+            write_all(header);
+            _end = FILE_HEADER_SIZE;
+        } else {
+            // 巨大なファイルでも読み込むのはヘッダだけにする
+            const std::uint64_t size =
+                std::min<std::uint64_t>(status.st_size, end);
+            std::uint8_t header[FILE_HEADER_SIZE];
+            if (size < FILE_HEADER_SIZE or
+                ::pread(_fd, header, FILE_HEADER_SIZE, 0) !=
+                    static_cast<ssize_t>(FILE_HEADER_SIZE) or
+                load_value<std::uint32_t>(header) != FILE_MAGIC) {
+                throw std::runtime_error("Not a result file: " + file_path);
+            }
+            if (load_value<std::uint32_t>(header + 4) != VERSION) {
+                throw std::runtime_error("Unsupported result file: " +
+                                         file_path);
+            }
+            if (load_value<std::uint64_t>(header + 8) != fingerprint) {
+                throw std::runtime_error("Result file for other rules: " +
+                                         file_path);
+            }
+            _blocks = scan_block_headers(_fd, size, _end);
+            for (const BlockEntry &block : _blocks) {
+                _record_size += block.record_size;
+            }
+            if (::ftruncate(_fd, _end) != 0 or
+                ::lseek(_fd, _end, SEEK_SET) < 0) {
+                throw std::runtime_error("Failed to truncate file: " +
+                                         file_path);
+            }
+        }
+        start_block();
+        _io_thread = std::thread([this] { write_blocks(); });
+    }
+
+    ResultWriter(const ResultWriter &) = delete;
+    ResultWriter &operator=(const ResultWriter &) = delete;
+
+    ~ResultWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    /// @brief 初手から moves を順に置いた局面を 1 レコードとして追加する
+    /// @param snapshot 完了した局面ではなく, 途中経過の局面かどうか
+    void append(const std::vector<Move> &moves, bool snapshot = false) {
+        using namespace result_stream;
+        assert(moves.size() < SNAPSHOT_FLAG);
+        std::vector<std::uint8_t> &block = current_block();
+        block.push_back(static_cast<std::uint8_t>(moves.size()) |
+                        (snapshot ? SNAPSHOT_FLAG : 0));
+        for (const Move &move : moves) {
+            append_value(block, encode_move(move));
+        }
+        _pending_records++;
+        if (block.size() >= BLOCK_HEADER_SIZE + BLOCK_PAYLOAD_SIZE) {
+            flush();
+        }
+    }
+
+    /// @brief 溜めているレコードを 1 ブロックとして I/O スレッドに渡す.
+    /// 書き出しの完了は待たない
+    void flush() {
+        using namespace result_stream;
+        if (_failed.load(std::memory_order_acquire)) {
+            std::rethrow_exception(_error);
+        }
+        if (_pending_records == 0) {
+            return;
+        }
+        std::vector<std::uint8_t> &block = current_block();
+        const auto payload_size =
+            static_cast<std::uint32_t>(block.size() - BLOCK_HEADER_SIZE);
+        store_value(block.data(), BLOCK_MAGIC);
+        store_value(block.data() + 4, _pending_records);
+        store_value(block.data() + 8, payload_size);
+        store_value(block.data() + 12, _record_size);
+        _blocks.push_back({_end, _record_size, _pending_records});
+        _record_size += _pending_records;
+        _end += block.size();
+        _pending_records = 0;
+
+        const std::uint32_t tail =
+            _queue_tail.load(std::memory_order_relaxed) + 1;
+        _queue_tail.store(tail, std::memory_order_release);
+        wake_io_thread();
+        // 次の枠がまだ書き出し待ちなら, I/O スレッドが空けるまで待つ
+        std::uint32_t head = _queue_head.load(std::memory_order_acquire);
+        if (tail - head >= QUEUE_SIZE) {
+            _stall_count++;
+            do {
+                _queue_head.wait(head, std::memory_order_acquire);
+                head = _queue_head.load(std::memory_order_acquire);
+            } while (tail - head >= QUEUE_SIZE);
+        }
+        start_block();
+    }
+
+    /// @brief 溜めているレコードを I/O スレッドに渡し, 書き出し待ちの枠が
+    /// なくなるまで待ってから fdatasync する. 戻った時点で size() 個の
+    /// レコードが offset() バイトまでディスクに載っている
+    void sync() {
+        flush();
+        const std::uint32_t tail = _queue_tail.load(std::memory_order_relaxed);
+        std::uint32_t head = _queue_head.load(std::memory_order_acquire);
+        while (head != tail) {
+            _queue_head.wait(head, std::memory_order_acquire);
+            head = _queue_head.load(std::memory_order_acquire);
+        }
+        if (_failed.load(std::memory_order_acquire)) {
+            std::rethrow_exception(_error);
+        }
+        if (::fdatasync(_fd) != 0) {
+            throw std::runtime_error("Failed to sync file: " + _file_path);
+        }
+    }
+
+    /// @brief 残りのレコードをすべて書き出し, 索引を書いてファイルを閉じる
+    void close() {
+        using namespace result_stream;
+        if (_fd < 0) {
+            return;
+        }
+        try {
+            flush();
+        } catch (...) {
+            stop_io_thread();
+            ::close(_fd);
+            _fd = -1;
+            throw;
+        }
+        stop_io_thread();
+        if (_failed.load(std::memory_order_acquire)) {
+            ::close(_fd);
+            _fd = -1;
+            std::rethrow_exception(_error);
+        }
+        std::vector<std::uint8_t> index;
+        for (const BlockEntry &block : _blocks) {
+            append_value(index, block.offset);
+            append_value(index, block.first_record);
+        }
+        append_value(index, static_cast<std::uint64_t>(_blocks.size()));
+        append_value(index, _end);
+        append_value(index, INDEX_MAGIC);
+        write_all(index);
+        ::close(_fd);
+        _fd = -1;
+    }
+
+    std::uint64_t size() const { return _record_size + _pending_records; }
+
+    /// @brief I/O スレッドに渡したブロックの終端の位置 (バイト)
+    std::uint64_t offset() const { return _end; }
+
+    /// @brief 書き出し待ちの枠が埋まっていて, 探索スレッドが待った回数
+    std::uint64_t stall_count() const { return _stall_count; }
+
+   private:
+    std::vector<std::uint8_t> &current_block() {
+        return _queue[_queue_tail.load(std::memory_order_relaxed) % QUEUE_SIZE];
+    }
+
+    /// @brief 枠 _queue_tail を空にし, ヘッダの分を空けておく
+    void start_block() {
+        std::vector<std::uint8_t> &block = current_block();
+        block.reserve(result_stream::BLOCK_HEADER_SIZE + BLOCK_PAYLOAD_SIZE +
+                      256);
+        block.assign(result_stream::BLOCK_HEADER_SIZE, 0);
+    }
+
+    /// @brief I/O スレッドの処理. 書き出し待ちの枠を先頭から順に書き出し,
+    /// _closing が立っていて書き出し待ちがなくなれば終わる.
+    /// 書き出しに失敗したら, 以降の枠は捨てて探索スレッドを待たせない
+    void write_blocks() {
+        std::uint32_t head = _queue_head.load(std::memory_order_relaxed);
+        while (true) {
+            // 先に読んでおけば, 確かめた後に渡されたブロックを見逃さない
+            const std::uint32_t wake_count =
+                _wake_count.load(std::memory_order_acquire);
+            const std::uint32_t tail =
+                _queue_tail.load(std::memory_order_acquire);
+            if (head == tail) {
+                if (_closing.load(std::memory_order_acquire)) {
+                    break;
+                }
+                _wake_count.wait(wake_count, std::memory_order_acquire);
+                continue;
+            }
+            if (!_failed.load(std::memory_order_relaxed)) {
+                try {
+                    write_all(_queue[head % QUEUE_SIZE]);
+                } catch (...) {
+                    _error = std::current_exception();
+                    _failed.store(true, std::memory_order_release);
+                }
+            }
+            head++;
+            _queue_head.store(head, std::memory_order_release);
+            _queue_head.notify_one();
+        }
+    }
+
+    void stop_io_thread() {
+        if (!_io_thread.joinable()) {
+            return;
+        }
+        _closing.store(true, std::memory_order_release);
+        wake_io_thread();
+        _io_thread.join();
+    }
+
+    void wake_io_thread() {
+        _wake_count.fetch_add(1, std::memory_order_release);
+        _wake_count.notify_one();
+    }
+
+    void write_all(const std::vector<std::uint8_t> &bytes) {
+        std::size_t written = 0;
+        while (written < bytes.size()) {
+            const ssize_t result =
+                ::write(_fd, bytes.data() + written, bytes.size() - written);
+            if (result < 0) {
+                throw std::runtime_error("Failed to write file: " +
+                                         _file_path);
+            }
+            written += result;
+        }
+    }
+};
+
+/// @brief ResultWriter の書いたファイルを mmap して読むリーダ
+class ResultReader {
+    const std::uint8_t *_data = nullptr;
+    std::size_t _size = 0;
+    std::vector<result_stream::BlockEntry> _blocks;
+    std::uint64_t _record_size = 0;
+    std::uint64_t _fingerprint = 0;
+
+   public:
+    /// @brief 1 つのレコード. ファイル上のバイト列を指す
+    class Record {
+        const std::uint8_t *_data;
+
+       public:
+        explicit Record(const std::uint8_t *data) : _data(data) {}
+
+        std::size_t size() const {
+            return _data[0] & ~result_stream::SNAPSHOT_FLAG;
+        }
+        bool is_snapshot() const {
+            return (_data[0] & result_stream::SNAPSHOT_FLAG) != 0;
+        }
+        Move operator[](std::size_t index) const {
+            return result_stream::decode_move(
+                result_stream::load_value<std::uint16_t>(_data + 1 +
+                                                         2 * index));
+        }
+        std::vector<Move> moves() const {
+            std::vector<Move> result(size());
+            for (std::size_t i = 0; i < result.size(); i++) {
+                result[i] = (*this)[i];
+            }
+            return result;
+        }
+        /// @brief 次のレコードの先頭
+        const std::uint8_t *end() const { return _data + 1 + 2 * size(); }
+    };
+
+    explicit ResultReader(const std::string &file_path) {
+        using namespace result_stream;
+        const int fd = ::open(file_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open file: " + file_path);
+        }
+        struct stat status {};
+        ::fstat(fd, &status);
+        _size = status.st_size;
+        if (_size < FILE_HEADER_SIZE) {
+            ::close(fd);
+            throw std::runtime_error("Not a result file: " + file_path);
+        }
+        void *mapped = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Failed to mmap file: " + file_path);
+        }
+        _data = static_cast<const std::uint8_t *>(mapped);
+        if (load_value<std::uint32_t>(_data) != FILE_MAGIC) {
+            ::munmap(const_cast<std::uint8_t *>(_data), _size);
+            throw std::runtime_error("Not a result file: " + file_path);
+        }
+        if (load_value<std::uint32_t>(_data + 4) != VERSION) {
+            ::munmap(const_cast<std::uint8_t *>(_data), _size);
+            throw std::runtime_error("Unsupported result file: " + file_path);
+        }
+        _fingerprint = load_value<std::uint64_t>(_data + 8);
+        if (!load_index()) {
+            std::size_t end = 0;
+            _blocks = scan_blocks(_data, _size, end);
+        }
+        for (const BlockEntry &block : _blocks) {
+            _record_size += block.record_size;
+        }
+    }
+
+    ResultReader(const ResultReader &) = delete;
+    ResultReader &operator=(const ResultReader &) = delete;
+
+    ~ResultReader() {
+        if (_data != nullptr) {
+            ::munmap(const_cast<std::uint8_t *>(_data), _size);
+        }
+    }
+
+    /// @brief レコードの総数
+    std::uint64_t size() const { return _record_size; }
+
+    /// @brief 局面を探索したルールの指紋 (rule_fingerprint)
+    std::uint64_t fingerprint() const { return _fingerprint; }
+
+    /// @brief 通し番号 index のレコードを返す. 索引でブロックを探し,
+    /// ブロック内を先頭から辿る
+    Record operator[](std::uint64_t index) const {
+        assert(index < _record_size);
+        auto it = std::upper_bound(
+            _blocks.begin(), _blocks.end(), index,
+            [](std::uint64_t value, const result_stream::BlockEntry &block) {
+                return value < block.first_record;
+            });
+        const result_stream::BlockEntry &block = *std::prev(it);
+        Record record(_data + block.offset + result_stream::BLOCK_HEADER_SIZE);
+        for (std::uint64_t i = block.first_record; i < index; i++) {
+            record = Record(record.end());
+        }
+        return record;
+    }
+
+    /// @brief すべてのレコードを順に f に渡す
+    template <class F>
+    void for_each(F &&f) const {
+        for (const result_stream::BlockEntry &block : _blocks) {
+            Record record(_data + block.offset +
+                          result_stream::BLOCK_HEADER_SIZE);
+            for (std::uint32_t i = 0; i < block.record_size; i++) {
+                f(record);
+                record = Record(record.end());
+            }
+        }
+    }
+
+   private:
+    /// @brief 末尾の索引を読む. 索引がなければ false を返す
+    bool load_index() {
+        using namespace result_stream;
+        if (_size < FILE_HEADER_SIZE + INDEX_TRAILER_SIZE) {
+            return false;
+        }
+        const std::uint8_t *trailer = _data + _size - INDEX_TRAILER_SIZE;
+        if (load_value<std::uint32_t>(trailer + 16) != INDEX_MAGIC) {
+            return false;
+        }
+        const auto block_size = load_value<std::uint64_t>(trailer);
+        const auto index_offset = load_value<std::uint64_t>(trailer + 8);
+        if (index_offset + 16 * block_size + INDEX_TRAILER_SIZE != _size) {
+            return false;
+        }
+        for (std::uint64_t i = 0; i < block_size; i++) {
+            const std::uint8_t *entry = _data + index_offset + 16 * i;
+            const auto offset = load_value<std::uint64_t>(entry);
+            _blocks.push_back({offset, load_value<std::uint64_t>(entry + 8),
+                               load_value<std::uint32_t>(_data + offset + 4)});
+        }
+        return true;
+    }
+};
+
+/// @brief 初手から moves を順に置いた局面を field (ファイルの指紋と
+/// 同じルールのフィールド) に再現する.
+/// 手順にパスは含めないので, 合法手の無いプレイヤーはパスしたものとして
+/// 手番を回す (パスしないルールの手順では, 手番のプレイヤーは必ず置ける)
+template <class FieldType>
+void replay(const std::vector<Move> &moves, FieldType &field) {
+    for (const Move &move : moves) {
+        field.pass_dead_players();
+        const Player player = static_cast<Player>(field.state().player);
+        field.place(move.position.x, move.position.y, move.orientation,
+                    player);
+    }
+}
@@ -0,0 +1,124 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#pragma once
+#include "pieces.hpp"
+#include "players.hpp"
+#include "position.hpp"
+
+// すべてのブロックを使うときのブロックの集合 (ビット i がブロック i)
+constexpr std::uint32_t ALL_BLOCKS = (std::uint32_t(1) << BLOCK_SIZE) - 1;
+
+/// @brief 先頭の size 個のブロック (小さいものから順) の集合
+constexpr std::uint32_t first_blocks(unsigned short size) {
+    return (std::uint32_t(1) << size) - 1;
+}
+
+// BasicField, BasicSolver などに渡すルールは, 以下を静的メンバに持つ型.
+// - FIELD_WIDTH: フィールドの縦横の長さ
+//   (MAX_BLOCK_CELL_SIZE 以上, 20 (ClassicRules の長さ) 以下)
+// - PLAYER_SIZE: プレイヤーの数 (1 以上 4 以下). 手番は番号順に回る
+// - START_POSITIONS: 各プレイヤーの初手で覆わなければならないマス
+// - BLOCKS: 使うブロックの集合 (ビット i がブロック i). 使わないブロックは
+//   最初から使用済みとして扱う
+// - PASSING (省略可): true なら合法手の無いプレイヤーはパスし, 全員が
+//   パスするまでゲームを続ける. false (既定) ならその局面で探索を打ち切る
+
+/// @brief 通常のブロックス. 20 x 20 の四隅から 4 人で打つ
+// 3...0
+// .....
+// .....
+// .....
+// 2...1
+struct ClassicRules {
+    static constexpr std::size_t FIELD_WIDTH = 20;
+    static constexpr unsigned short PLAYER_SIZE = 4;
+    static constexpr std::array<Position, PLAYER_SIZE> START_POSITIONS = {
+        Position(0, FIELD_WIDTH - 1),
+        Position(FIELD_WIDTH - 1, FIELD_WIDTH - 1),
+        Position(FIELD_WIDTH - 1, 0), Position(0, 0)};
+    static constexpr std::uint32_t BLOCKS = ALL_BLOCKS;
+};
+
+/// @brief ブロックス デュオ. 14 x 14 の (4, 4) と (9, 9) から 2 人で打つ
+struct DuoRules {
+    static constexpr std::size_t FIELD_WIDTH = 14;
+    static constexpr unsigned short PLAYER_SIZE = 2;
+    static constexpr std::array<Position, PLAYER_SIZE> START_POSITIONS = {
+        Position(4, 4), Position(9, 9)};
+    static constexpr std::uint32_t BLOCKS = ALL_BLOCKS;
+};
+
+/// @brief 全探索を終えられる大きさにした研究用の盤面. WIDTH x WIDTH
+/// の向かい合う角 (右上と左下) から 2 人で, BLOCKS のブロックだけを使って打つ
+template <std::size_t WIDTH, std::uint32_t BLOCK_SET>
+struct DuelRules {
+    static constexpr std::size_t FIELD_WIDTH = WIDTH;
+    static constexpr unsigned short PLAYER_SIZE = 2;
+    static constexpr std::array<Position, PLAYER_SIZE> START_POSITIONS = {
+        Position(0, WIDTH - 1), Position(WIDTH - 1, 0)};
+    static constexpr std::uint32_t BLOCKS = BLOCK_SET;
+};
+
+/// @brief --rules mini で探索するルール. 6 x 6 で小さい方から 4 個の
+/// ブロックだけを使う
+using MiniRules = DuelRules<6, first_blocks(4)>;
+
+/// @brief ルール Base で, 合法手の無いプレイヤーがパスするようにしたもの
+/// (実際のブロックスと同じ)
+template <class Base>
+struct WithPassing : Base {
+    static constexpr bool PASSING = true;
+};
+
+/// @brief ルールで合法手の無いプレイヤーがパスするかどうか
+template <class Rules>
+constexpr bool rule_passes() {
+    if constexpr (requires { Rules::PASSING; }) {
+        return Rules::PASSING;
+    } else {
+        return false;
+    }
+}
+
+/// @brief ルールで使うブロックの数
+template <class Rules>
+constexpr unsigned short rule_block_size() {
+    unsigned short size = 0;
+    for (unsigned short block = 0; block < BLOCK_SIZE; block++) {
+        size += (Rules::BLOCKS >> block) & 1;
+    }
+    return size;
+}
+
+/// @brief ルールでの 1 ゲームのターン数の最大値
+template <class Rules>
+constexpr unsigned short rule_max_turn() {
+    return Rules::PLAYER_SIZE * rule_block_size<Rules>();
+}
+
+/// @brief splitmix64 の混ぜ合わせ. state に value を吸収する
+constexpr std::uint64_t absorb_hash(std::uint64_t state, std::uint64_t value) {
+    std::uint64_t z = state + value + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/// @brief ルールの指紋. フィールドの長さ, プレイヤーの数, 開始マス,
+/// ブロックの集合, パスするかどうかから決まる. ファイルに書いておき,
+/// 別のルールで作ったファイルを開こうとしたらエラーにする.
+/// seed にはファイル形式の版などを渡す
+template <class Rules>
+constexpr std::uint64_t rule_fingerprint(std::uint64_t seed = 0) {
+    std::uint64_t fingerprint = seed;
+    fingerprint = absorb_hash(fingerprint, Rules::FIELD_WIDTH);
+    fingerprint = absorb_hash(fingerprint, Rules::PLAYER_SIZE);
+    for (const Position &position : Rules::START_POSITIONS) {
+        fingerprint = absorb_hash(fingerprint, position.x);
+        fingerprint = absorb_hash(fingerprint, position.y);
+    }
+    fingerprint = absorb_hash(fingerprint, Rules::BLOCKS);
+    return absorb_hash(fingerprint, rule_passes<Rules>());
+}
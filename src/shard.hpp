@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#pragma once
+#include "move.hpp"
+#include "parallel_solver.hpp"
+#include "result_stream.hpp"
+#include "solver.hpp"
+
+/// @brief 初手から prefix_depth 手目までの手順 (プレフィックス) のうち,
+/// 1 つのプロセスが担当するもの. プレフィックスには Solver::split
+/// の列挙順に 0 から番号を振る. 列挙順は合法手の生成順だけで決まるので,
+/// どのプロセスでも同じ番号になる
+struct ShardSelection {
+    // --shard index/count: 番号を count で割った余りが index のものを担当する
+    std::size_t index = 0, count = 1;
+    // --prefixes a,b,c: 番号を直接指定する. 空でなければこちらを優先する
+    std::vector<std::size_t> prefixes;
+
+    bool contains(std::size_t prefix_index) const {
+        if (!prefixes.empty()) {
+            return std::find(prefixes.begin(), prefixes.end(),
+                             prefix_index) != prefixes.end();
+        }
+        return prefix_index % count == index;
+    }
+
+    /// @brief "i/N" 形式の文字列を読む
+    static ShardSelection parse_shard(const std::string &text) {
+        const std::size_t slash = text.find('/');
+        if (slash == std::string::npos) {
+            throw std::invalid_argument("Invalid shard: " + text);
+        }
+        ShardSelection selection;
+        selection.index = std::stoul(text.substr(0, slash));
+        selection.count = std::stoul(text.substr(slash + 1));
+        if (selection.count == 0 or selection.index >= selection.count) {
+            throw std::invalid_argument("Invalid shard: " + text);
+        }
+        return selection;
+    }
+
+    /// @brief "a,b,c" 形式の文字列を読む
+    static ShardSelection parse_prefixes(const std::string &text) {
+        ShardSelection selection;
+        std::istringstream stream(text);
+        std::string token;
+        while (std::getline(stream, token, ',')) {
+            selection.prefixes.push_back(std::stoul(token));
+        }
+        if (selection.prefixes.empty()) {
+            throw std::invalid_argument("Invalid prefixes: " + text);
+        }
+        return selection;
+    }
+};
+
+/// @brief 1 つのシャードの集計結果. 以下の形式のテキストで読み書きする
+/// prefix_depth <プレフィックスの手数>
+/// prefix_count <プレフィックスの総数>
+/// trunk <total_steps> <complete_games>
+/// prefix <番号> <total_steps> <complete_games>
+/// ...
+/// trunk はプレフィックスより浅い部分の集計で, どのシャードも同じ値を持つ
+struct ShardResult {
+    unsigned short prefix_depth = 0;
+    std::size_t prefix_count = 0;
+    SearchStats trunk;
+    std::vector<std::pair<std::size_t, SearchStats>> prefixes;
+
+    void write(std::ostream &stream) const {
+        stream << "prefix_depth " << prefix_depth << '\n';
+        stream << "prefix_count " << prefix_count << '\n';
+        stream << "trunk " << trunk.total_steps << ' ' << trunk.complete_games
+               << '\n';
+        for (const auto &[index, stats] : prefixes) {
+            stream << "prefix " << index << ' ' << stats.total_steps << ' '
+                   << stats.complete_games << '\n';
+        }
+    }
+
+    static ShardResult read(std::istream &stream) {
+        ShardResult result;
+        std::string key;
+        while (stream >> key) {
+            if (key == "prefix_depth") {
+                stream >> result.prefix_depth;
+            } else if (key == "prefix_count") {
+                stream >> result.prefix_count;
+            } else if (key == "trunk") {
+                stream >> result.trunk.total_steps >>
+                    result.trunk.complete_games;
+            } else if (key == "prefix") {
+                std::size_t index;
+                SearchStats stats;
+                stream >> index >> stats.total_steps >> stats.complete_games;
+                result.prefixes.emplace_back(index, stats);
+            } else {
+                throw std::runtime_error("Unknown key in shard result: " +
+                                         key);
+            }
+            if (!stream) {
+                throw std::runtime_error("Malformed shard result near: " + key);
+            }
+        }
+        return result;
+    }
+};
+
+/// @brief selection が担当するプレフィックスを列挙順に返す
+std::vector<std::vector<Move>> shard_prefixes(const ShardSelection &selection,
+                                              unsigned short prefix_depth) {
+    Solver splitter;
+    splitter.set_save_positions(false);
+    std::vector<std::vector<Move>> prefixes;
+    splitter.split({}, prefix_depth, prefixes);
+    std::vector<std::vector<Move>> selected;
+    for (std::size_t index = 0; index < prefixes.size(); index++) {
+        if (selection.contains(index)) {
+            selected.push_back(std::move(prefixes[index]));
+        }
+    }
+    return selected;
+}
+
+/// @brief selection が担当するプレフィックス以下の部分木をそれぞれ探索する.
+/// thread_size が 2 以上なら, 各部分木をさらに ParallelSolver で分割する.
+/// 局面は output_path (並列なら output_path-t<番号>) に書き出す.
+/// prefix_depth 手目までに終わった局面は, プレフィックス 0 を担当する
+/// シャードだけが output_path-split に書き出す. 並列なら, 各部分木を
+/// 分ける手目までに終わった局面も同じ output_path-split に書き出す.
+/// table を渡すと, すべての部分木の探索でその置換表を共有する.
+/// telemetry を渡すと, 計測値をそこへ報告する.
+/// cache を渡すと, 同時に動く別のシャードや次の実行とそのキャッシュを共有する
+ShardResult solve_shard(const ShardSelection &selection,
+                        unsigned short prefix_depth,
+                        unsigned short thread_size,
+                        unsigned short split_depth,
+                        const std::string &output_path,
+                        TranspositionTable *table = nullptr,
+                        TelemetryLog *telemetry = nullptr,
+                        SubtreeCache *cache = nullptr) {
+    ShardResult result;
+    result.prefix_depth = prefix_depth;
+
+    Solver splitter;
+    std::optional<ResultWriter> split_writer;
+    if (selection.contains(0) or thread_size > 1) {
+        split_writer.emplace(output_path + "-split",
+                             rule_fingerprint<ClassicRules>());
+    }
+    if (selection.contains(0)) {
+        splitter.set_output(&*split_writer);
+    } else {
+        splitter.set_save_positions(false);
+    }
+    std::vector<std::vector<Move>> prefixes;
+    splitter.split({}, prefix_depth, prefixes);
+    result.prefix_count = prefixes.size();
+    result.trunk = splitter.stats();
+    for (std::size_t index : selection.prefixes) {
+        if (index >= prefixes.size()) {
+            throw std::out_of_range("Prefix index out of range: " +
+                                    std::to_string(index));
+        }
+    }
+
+    std::optional<ResultWriter> writer;
+    if (thread_size <= 1) {
+        writer.emplace(output_path, rule_fingerprint<ClassicRules>());
+    }
+    for (std::size_t index = 0; index < prefixes.size(); index++) {
+        if (!selection.contains(index)) {
+            continue;
+        }
+        if (thread_size <= 1) {
+            Solver solver;
+            solver.set_output(&*writer);
+            solver.set_transposition_table(table);
+            solver.set_telemetry(telemetry);
+            solver.set_subtree_cache(cache);
+            solver.solve(prefixes[index]);
+            result.prefixes.emplace_back(index, solver.stats());
+        } else {
+            ParallelSolver solver(thread_size, split_depth, output_path,
+                                  table);
+            solver.set_split_output(&*split_writer);
+            solver.set_telemetry(telemetry);
+            solver.set_subtree_cache(cache);
+            solver.solve(prefixes[index]);
+            result.prefixes.emplace_back(index, solver.stats());
+        }
+    }
+    if (split_writer) {
+        split_writer->close();
+    }
+    return result;
+}
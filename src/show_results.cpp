@@ -0,0 +1,63 @@
+#include <iostream>
+#include <string>
+
+#include "field.hpp"
+#include "result_stream.hpp"
+#include "rules.hpp"
+
+/// @brief index 番目の局面を, ルール Rules のフィールドに再現して出力する
+template <class Rules>
+void write_position(const ResultReader &reader, std::uint64_t index) {
+    BasicField<Rules> field;
+    replay(reader[index].moves(), field);
+    field.write(std::cout);
+}
+
+/// @brief ファイルの指紋がルール Base (とそのパスするもの) と一致すれば,
+/// index 番目の局面を出力して true を返す
+template <class Base>
+bool write_position_if(const ResultReader &reader, std::uint64_t index) {
+    if (reader.fingerprint() == rule_fingerprint<Base>()) {
+        write_position<Base>(reader, index);
+        return true;
+    }
+    if (reader.fingerprint() == rule_fingerprint<WithPassing<Base>>()) {
+        write_position<WithPassing<Base>>(reader, index);
+        return true;
+    }
+    return false;
+}
+
+/// @brief ResultWriter の書いたファイルを読む.
+/// INDEX を省略するとレコード数を, 指定するとその局面の盤面を出力する.
+/// 盤面はファイルの指紋から選んだルール (main の --rules, --pass
+/// で選べるもの) のフィールドに再現する
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " FILE [INDEX]" << std::endl;
+        return 1;
+    }
+    const ResultReader reader(argv[1]);
+    if (argc < 3) {
+        std::uint64_t snapshots = 0;
+        reader.for_each([&](const ResultReader::Record &record) {
+            snapshots += record.is_snapshot();
+        });
+        std::cout << "records " << reader.size() << '\n';
+        std::cout << "complete_games " << reader.size() - snapshots << '\n';
+        std::cout << "snapshots " << snapshots << std::endl;
+        return 0;
+    }
+
+    const std::uint64_t index = std::stoull(argv[2]);
+    if (index >= reader.size()) {
+        std::cerr << "Index out of range: " << index << std::endl;
+        return 1;
+    }
+    if (!write_position_if<ClassicRules>(reader, index) and
+        !write_position_if<DuoRules>(reader, index) and
+        !write_position_if<MiniRules>(reader, index)) {
+        std::cerr << "Unknown rules in file: " << argv[1] << std::endl;
+        return 1;
+    }
+}
@@ -1,106 +1,634 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cstdint>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-#include "blocks.hpp"
+#pragma once
+#include "aggregate.hpp"
+#include "checkpoint.hpp"
+#include "endgame.hpp"
 #include "field.hpp"
+#include "move.hpp"
+#include "pieces.hpp"
 #include "players.hpp"
 #include "position.hpp"
+#include "result_stream.hpp"
+#include "rules.hpp"
+#include "subtree_cache.hpp"
+#include "telemetry.hpp"
+#include "transposition_table.hpp"
 
-class Solver {
-    Field _field;
-    // 各プレイヤーのブロック集合を表す配列 (回転, 裏返し含む) .
-    // _blocks[i] := プレイヤー i のブロック集合.
-    // 8 つごとに回転と裏返しで同じブロックを表す.
-    // (i.e. j を 8 の倍数として, _blocks[i][j], ..., _blocks[i][j + 8]
-    // は回転と裏返しにより一致する)
-    std::array<std::array<Block, TOTAL_BLOCK_SIZE>, PLAYER_SIZE> _blocks{};
-    // 各プレイヤーについて, どのブロックが使用済みかどうかを借りする配列.
-    // _used[i][j] := プレイヤー i のブロック j が使用済みかどうか
-    std::array<std::array<bool, BLOCK_SIZE>, PLAYER_SIZE> _used{};
+// 1 ゲームのターン数の最大値. 深さごとの集計はどのルールでもこの大きさで持つ
+constexpr unsigned short MAX_TURN = PLAYER_SIZE * BLOCK_SIZE;
+// 計測値を TelemetryLog に報告する間隔 (ブロックを置く回数)
+constexpr unsigned TELEMETRY_REPORT_STEPS = 1 << 16;
+
+/// @brief 探索の集計結果. スレッドごとに数えて足し合わせる
+struct SearchStats {
+    // ブロックを置いた回数 (探索木のノード数)
     unsigned long long total_steps = 0;
+    // 全プレイヤーがすべてのブロックを使い切った局面の数
+    unsigned long long complete_games = 0;
+
+    SearchStats &operator+=(const SearchStats &other) {
+        total_steps += other.total_steps;
+        complete_games += other.complete_games;
+        return *this;
+    }
+
+    SearchStats operator-(const SearchStats &other) const {
+        return {total_steps - other.total_steps,
+                complete_games - other.complete_games};
+    }
+};
+
+/// @brief 置換表を使ったときの深さ (ターン数) ごとの集計.
+/// - expanded[i]: ターン i で置換表やキャッシュに無く, 子を展開した局面の数.
+///   置換表が十分大きく上書きが起きなければ, ターン i の相異なる局面の数になる
+/// - hits[i]: ターン i で置換表から部分木の集計を引けた局面の数
+/// - cached[i]: ターン i で SubtreeCache から部分木の集計を引けた局面の数
+/// - independent[i]: ターン i で EndgameAnalyzer がプレイヤーごとに分けて
+///   部分木を数えた局面の数
+struct TableStats {
+    std::array<unsigned long long, MAX_TURN + 1> expanded{};
+    std::array<unsigned long long, MAX_TURN + 1> hits{};
+    std::array<unsigned long long, MAX_TURN + 1> cached{};
+    std::array<unsigned long long, MAX_TURN + 1> independent{};
+
+    TableStats &operator+=(const TableStats &other) {
+        for (unsigned short turn = 0; turn <= MAX_TURN; turn++) {
+            expanded[turn] += other.expanded[turn];
+            hits[turn] += other.hits[turn];
+            cached[turn] += other.cached[turn];
+            independent[turn] += other.independent[turn];
+        }
+        return *this;
+    }
+};
+
+/// @brief ルール Rules (rules.hpp) の探索木を探索する.
+/// パスするルールでは, 合法手の無いプレイヤーを飛ばして次のプレイヤーが置き,
+/// 全員がパスした局面を葉とする. パスは手順にもターン数にも含めない.
+/// フィールドの実装は FieldType (FieldBackend を満たすもの) で選べ,
+/// どれでも探索の順と集計は同じになる.
+/// 手順を ResultWriter に書き出すときのマスの番号は通常のフィールドの長さで
+/// 付けるので, フィールドはそれ以下の大きさであること
+template <class Rules, template <class> class FieldType = BasicField>
+class BasicSolver {
+    using Field = FieldType<Rules>;
+    static_assert(FieldBackend<Field>);
+    static constexpr unsigned short PLAYER_SIZE = Rules::PLAYER_SIZE;
+    // 1 ゲームのターン数の最大値
+    static constexpr unsigned short MAX_TURN = rule_max_turn<Rules>();
+    static_assert(MAX_TURN <= ::MAX_TURN);
+    // 合法手の無いプレイヤーがパスするかどうか
+    static constexpr bool PASSING = rule_passes<Rules>();
+    static_assert(Rules::FIELD_WIDTH <= FIELD_WIDTH);
+
+    // 盤面. 使用済みのブロックと手番も _field.state() が持つ
+    Field _field;
+    SearchStats _stats;
+    // 合法手を格納する配列. 再確保を避けるため深さ (ターン数) ごとに使い回す.
+    // _moves[i] := ターン i の合法手
+    std::array<std::vector<Move>, MAX_TURN + 1> _moves{};
+    // 初手から現在の局面までの手順
+    std::vector<Move> _path;
+    // 局面の出力先. nullptr なら局面ごとに ../output/ 以下のファイルへ書き出す
+    ResultWriter *_output = nullptr;
+    // false なら局面を書き出さない
+    bool _save_positions = true;
+    // 探索しながら数える集計. nullptr なら数えない
+    BasicGameAggregates<Rules> *_aggregates = nullptr;
+    // 探索スタック. _next[i] := ターン i の局面で次に試す _moves[i] の添字
+    std::array<std::size_t, MAX_TURN + 1> _next{};
+    // 探索を始めた局面のターン数 (= スタックの底)
+    unsigned short _root_turn = 0;
+    // split で探索を打ち切るターン数と, 打ち切った局面の手順の格納先
+    unsigned short _split_turn = 0;
+    std::vector<std::vector<Move>> *_prefixes = nullptr;
+    // チェックポイントの出力先と, 書き出す間隔 (total_steps の増分)
+    std::string _checkpoint_path;
+    unsigned long long _checkpoint_interval = 0;
+    unsigned long long _next_checkpoint = 0;
+    // 部分木の集計を共有する置換表. nullptr なら使わない
+    TranspositionTable *_table = nullptr;
+    // 実行をまたいで部分木の集計を残すキャッシュ. nullptr なら使わない
+    SubtreeCache *_cache = nullptr;
+    // このターン以降の局面で終盤の解析を試す. 解析しないなら空
+    unsigned short _endgame_turn = 0;
+    std::optional<BasicEndgameAnalyzer<Rules, FieldType>> _endgame;
+    TableStats _table_stats;
+    // _entry_stats[i] := ターン i の局面に入った時点の _stats.
+    // 局面を出るときの差分がその部分木の集計になる.
+    // _entry_valid[i] が false (チェックポイントから復元した局面) なら登録しない.
+    // _entry_keys[i] := その局面の置換表とキャッシュのキー
+    std::array<SearchStats, MAX_TURN + 1> _entry_stats{};
+    std::array<bool, MAX_TURN + 1> _entry_valid{};
+    std::array<SubtreeKey, MAX_TURN + 1> _entry_keys{};
+    // 計測値の報告先. nullptr なら報告しない
+    TelemetryLog *_telemetry = nullptr;
+    // 前回報告した時点の telemetry_counters と, 次の報告までの残りの手数
+    TelemetryCounters _telemetry_reported;
+    unsigned _telemetry_countdown = TELEMETRY_REPORT_STEPS;
 
    public:
-    Solver() { setup_blocks(); }
-    void solve() { place(PLAYER_A); }
+    BasicSolver() { _path.reserve(MAX_TURN); }
+    void solve() { solve({}); }
+
+    /// @brief prefix を初手から順に置いた局面以下を探索する.
+    /// prefix の手自体は total_steps に数えない
+    void solve(const std::vector<Move> &prefix) {
+        play(prefix);
+        search();
+        undo(prefix);
+    }
+
+    /// @brief checkpoint を保存した時点の状態に戻し, 探索を続ける.
+    /// 合法手の並びは局面から一意に決まるので, 途中で止めなかった場合と
+    /// 同じ順に探索し, 同じ集計結果になる. 局面を書き出すなら, 出力先は
+    /// checkpoint.output_offset で開き直したもので, 保存した時点の
+    /// レコード数と一致していなければならない
+    void resume(const Checkpoint &checkpoint) {
+        if (checkpoint.fingerprint != rule_fingerprint<Rules>()) {
+            throw std::runtime_error("Checkpoint for other rules");
+        }
+        if (_output != nullptr and checkpoint.output_offset != 0 and
+            _output->size() != checkpoint.output_records) {
+            throw std::runtime_error(
+                "Result file does not match the checkpoint");
+        }
+        play(checkpoint.root);
+        _root_turn = _field.current_turn;
+        _stats.total_steps = checkpoint.total_steps;
+        _stats.complete_games = checkpoint.complete_games;
+        for (std::size_t depth = 0; depth < checkpoint.next.size(); depth++) {
+            const unsigned short turn = _field.current_turn;
+            if (pass_dead_players()) {
+                _field.generate_moves(current_player(), _moves[turn]);
+            } else {
+                _moves[turn].clear();
+            }
+            _next[turn] = checkpoint.next[depth];
+            _entry_valid[turn] = false;
+            if (depth == checkpoint.path.size()) {
+                break;
+            }
+            // 保存した手順が, 生成し直した合法手の並びと一致するか確かめる
+            const Move &move = checkpoint.path[depth];
+            if (_next[turn] == 0 or _next[turn] > _moves[turn].size() or
+                !is_same_move(_moves[turn][_next[turn] - 1], move)) {
+                throw std::runtime_error("Checkpoint does not match the search");
+            }
+            push(move);
+        }
+        for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            if (_field.state().used_blocks(player) !=
+                checkpoint.used[player]) {
+                throw std::runtime_error("Checkpoint does not match the search");
+            }
+        }
+        _next_checkpoint = _stats.total_steps + _checkpoint_interval;
+        run();
+        report_telemetry();
+        undo(_path);
+    }
+
+    /// @brief total_steps が interval 増えるごとに, 探索の途中経過を
+    /// file_path に書き出す. interval が 0 なら書き出さない
+    void set_checkpoint(const std::string &file_path,
+                        unsigned long long interval) {
+        _checkpoint_path = file_path;
+        _checkpoint_interval = interval;
+    }
+
+    /// @brief root を置いた局面から depth 手先までを探索し,
+    /// depth 手先の局面に至る手順を prefixes に追加する.
+    /// root より後, depth 手先までに置いた手は total_steps に数える
+    void split(const std::vector<Move> &root, unsigned short depth,
+               std::vector<std::vector<Move>> &prefixes) {
+        play(root);
+        _split_turn = _field.current_turn + depth;
+        _prefixes = &prefixes;
+        search();
+        _prefixes = nullptr;
+        undo(root);
+    }
+
+    /// @brief root を置いた局面から depth 手先までの, 手数ごとの局面の数を
+    /// 数える (チェスの perft と同じ). 局面は出力せず, _stats も変えない.
+    /// 最後の 1 手はブロックを置かずに合法手の数だけを数える
+    /// @return counts[i] := root から i 手目の局面の数 (counts[0] = 1)
+    std::vector<unsigned long long> count(const std::vector<Move> &root,
+                                          unsigned short depth) {
+        play(root);
+        depth = std::min<unsigned short>(depth,
+                                         MAX_TURN - _field.current_turn);
+        std::vector<unsigned long long> counts(depth + 1, 0);
+        counts[0] = 1;
+        if (depth > 0) {
+            count_nodes(depth, 0, counts);
+        }
+        undo(root);
+        return counts;
+    }
+
+    /// @brief root を置いた局面から, 合法手を 1 つずつ無作為に選んで
+    /// 子のない局面までたどる (Knuth の推定). 各局面の合法手の数に,
+    /// それまでに選んだ手の確率の逆数を掛けたものが, 次のターンの局面の数の
+    /// 不偏推定値になる. weighted なら, マスの多いブロックの手ほど選びやすく
+    /// する (重点サンプリング). 確率の逆数を掛けるので推定は偏らない.
+    /// 局面は出力せず, _stats も変えない
+    /// @param estimates estimates[i] にターン i の局面の数の推定値を足す.
+    /// 大きさは MAX_TURN + 1 以上
+    /// @return 全プレイヤーがすべてのブロックを使い切った局面に達すれば
+    /// その数の推定値, 達しなければ 0
+    double probe(const std::vector<Move> &root, std::mt19937_64 &random,
+                 bool weighted, std::vector<double> &estimates) {
+        play(root);
+        const std::size_t root_size = _path.size();
+        double weight = 1;
+        double complete_games = 0;
+        while (true) {
+            if (_field.state().is_all_blocks_used()) {
+                complete_games = weight;
+                break;
+            }
+            if (!pass_dead_players()) {
+                break;
+            }
+            const unsigned short turn = _field.current_turn;
+            const Player player = current_player();
+            std::vector<Move> &moves = _moves[turn];
+            _field.generate_moves(player, moves);
+            if (moves.empty()) {
+                break;
+            }
+            estimates[turn + 1] += weight * moves.size();
+            std::size_t chosen;
+            if (weighted) {
+                unsigned total = 0;
+                for (const Move &move : moves) {
+                    total += ORIENTATIONS[move.orientation].cell_size;
+                }
+                unsigned rest =
+                    std::uniform_int_distribution<unsigned>(0, total - 1)(
+                        random);
+                chosen = 0;
+                while (rest >= ORIENTATIONS[moves[chosen].orientation]
+                                   .cell_size) {
+                    rest -= ORIENTATIONS[moves[chosen].orientation].cell_size;
+                    chosen++;
+                }
+                weight *= static_cast<double>(total) /
+                          ORIENTATIONS[moves[chosen].orientation].cell_size;
+            } else {
+                chosen = std::uniform_int_distribution<std::size_t>(
+                    0, moves.size() - 1)(random);
+                weight *= moves.size();
+            }
+            push(moves[chosen]);
+        }
+        while (_path.size() > root_size) {
+            pop();
+        }
+        undo(root);
+        return complete_games;
+    }
+
+    /// @brief 局面の出力先を output に切り替える. 局面は手順として書き出す.
+    /// nullptr を渡すと局面ごとのファイルへの出力に戻る
+    void set_output(ResultWriter *output) { _output = output; }
+
+    /// @brief false にすると局面を書き出さない. 集計だけが要るときに使う
+    void set_save_positions(bool save) { _save_positions = save; }
+
+    /// @brief ブロックを置くたびと終局するたびに aggregates に数える.
+    /// 置換表, キャッシュ, 終盤の解析で省いた部分木は数えないので,
+    /// それらとは一緒に使わないこと
+    void set_aggregates(BasicGameAggregates<Rules> *aggregates) {
+        _aggregates = aggregates;
+    }
+
+    /// @brief 部分木の集計を table に登録し, 同じ局面 (各プレイヤーの盤面,
+    /// 使用済みブロック, 手番) に再び達したら探索せずに集計だけを足す.
+    /// 集計は置換表なしと一致するが, 置換表から引いた部分木の局面は出力しない.
+    /// split 中は使わない
+    void set_transposition_table(TranspositionTable *table) { _table = table; }
+
+    /// @brief 置換表と同じように部分木の集計を cache に登録し, 引けた局面は
+    /// 探索しない. 置換表を引いた後に引き, cache->min_steps() 以上の
+    /// 部分木だけを登録する. split 中は使わない
+    void set_subtree_cache(SubtreeCache *cache) { _cache = cache; }
+
+    /// @brief ターン turn 以降の局面で, 各プレイヤーの置きうるマスが互いに
+    /// 重ならなくなったら, 探索せずに EndgameAnalyzer で部分木を数える.
+    /// 集計は解析なしと一致するが, 解析した部分木の局面は出力しない.
+    /// 解析は局面ごとに到達範囲を調べるので, 重なりやすい序盤は避ける.
+    /// 0 なら解析しない. split 中は使わない
+    void set_endgame_turn(unsigned short turn) {
+        _endgame_turn = turn;
+        if (turn != 0 and !_endgame) {
+            _endgame.emplace();
+        }
+    }
+
+    /// @brief このスレッドの telemetry_counters の増分を, 探索中に
+    /// 一定の手数ごとと探索の終わりに telemetry へ報告する
+    void set_telemetry(TelemetryLog *telemetry) {
+        _telemetry = telemetry;
+        _telemetry_reported = telemetry_counters;
+    }
+
+    const SearchStats &stats() const { return _stats; }
+    const TableStats &table_stats() const { return _table_stats; }
 
    private:
-    /// @brief player を指定し、バックトラックでブロックを置く
-    /// @param player
-    void place(const Player &player) {
-        // すべてブロックを使っていれば return
-        if (is_all_blocks_used()) {
-            auto t = std::time(nullptr);
-            auto tm = *std::localtime(&t);
-            std::ostringstream oss;
-            oss << std::put_time(&tm, "%Y-%m-%d-%H-%M-%S");
-            std::string filename = oss.str();
-            _field.save_to_file("../output/" + filename);
+    Player current_player() const {
+        return static_cast<Player>(_field.state().player);
+    }
+
+    /// @brief パスするルールなら, 手番のプレイヤーから順に合法手の無い
+    /// プレイヤーをパスさせる. パスしないルールでは何もしない
+    /// @return 全員がパスした (終局した) なら false
+    bool pass_dead_players() {
+        if constexpr (PASSING) {
+            return _field.pass_dead_players();
+        } else {
+            return true;
+        }
+    }
+
+    /// @brief prefix を順に置く
+    void play(const std::vector<Move> &prefix) {
+        for (const Move &move : prefix) {
+            push(move);
+        }
+    }
+
+    /// @brief play(prefix) で置いたブロックを取り除く
+    void undo(const std::vector<Move> &prefix) {
+        const std::size_t size = prefix.size();
+        for (std::size_t i = 0; i < size; i++) {
+            pop();
+        }
+    }
+
+    /// @brief 手番のプレイヤーが move を置く
+    void push(const Move &move) {
+        const Player player = current_player();
+        assert(_field.is_able_to_place(move.position.x, move.position.y,
+                                       move.orientation, player));
+        _field.place(move.position.x, move.position.y, move.orientation,
+                     player);
+        _path.push_back(move);
+    }
+
+    /// @brief 現在の局面を出力する
+    /// @param snapshot 途中経過として出力するかどうか
+    void save_field(bool snapshot) {
+        if (!_save_positions) {
             return;
         }
-        if (total_steps % 100000 == 0) {
-            auto t = std::time(nullptr);
-            auto tm = *std::localtime(&t);
-            std::ostringstream oss;
-            oss << std::put_time(&tm, "%Y-%m-%d-%H-%M-%S");
-            std::string filename = oss.str();
-            _field.save_to_file("../output/" + filename);
-        }
-        for (unsigned short block_idx = 0; block_idx < TOTAL_BLOCK_SIZE;
-             block_idx++) {
-            for (unsigned short x = 0; x < FIELD_WIDTH; x++) {
-                for (unsigned short y = 0; y < FIELD_WIDTH; y++) {
-                    Block &candidate_block = _blocks[player][block_idx];
-                    unsigned short use_idx = block_idx / BLOCK_MODE_SIZE;
-
-                    if (_used[player][use_idx]) {
-                        continue;
-                    }
-                    if (_field.is_able_to_place(x, y, candidate_block,
-                                                player)) {
-                        total_steps++;
-                        // ブロックを配置
-                        _field.place(x, y, candidate_block, player);
-                        _used[player][use_idx] = true;
-                        place(next_player(player));
-                        // _field.show();
-                        // ブロックを削除 (バックトラック)
-                        _field.remove(x, y, candidate_block);
-                        _used[player][use_idx] = false;
-                    }
+        if (_output != nullptr) {
+            _output->append(_path, snapshot);
+            return;
+        }
+        auto t = std::time(nullptr);
+        auto tm = *std::localtime(&t);
+        std::ostringstream oss;
+        oss << std::put_time(&tm, "%Y-%m-%d-%H-%M-%S");
+        std::string filename = oss.str();
+        _field.save_to_file("../output/" + filename);
+    }
+
+    /// @brief 現在の局面以下をバックトラックで探索する
+    void search() {
+        _root_turn = _field.current_turn;
+        _next_checkpoint = _stats.total_steps + _checkpoint_interval;
+        if (enter()) {
+            run();
+        }
+        report_telemetry();
+    }
+
+    /// @brief 局面に入ったときの処理を行い, 子の局面を展開するなら
+    /// 合法手を _moves に用意して true を返す
+    bool enter() {
+        const unsigned short turn = _field.current_turn;
+        // split 中であれば, 打ち切るターンに達した局面の手順を記録して return.
+        // この局面自体は solve(prefix) の側で扱う
+        if (_prefixes != nullptr and turn == _split_turn) {
+            _prefixes->push_back(_path);
+            return false;
+        }
+        // すべてブロックを使っていれば return
+        if (_field.state().is_all_blocks_used()) {
+            _stats.complete_games++;
+            count_end();
+            save_field(false);
+            return false;
+        }
+        // 全員がパスすれば終局. 置換表のキーの手番はパスの後のもの
+        if (!pass_dead_players()) {
+            count_end();
+            return false;
+        }
+        const bool memoized =
+            (_table != nullptr or _cache != nullptr) and _prefixes == nullptr;
+        if (memoized) {
+            const SubtreeKey &key = _entry_keys[turn] =
+                subtree_key(_field.state());
+            std::uint64_t steps, games;
+            if (_table != nullptr and _table->probe(key, steps, games)) {
+                _stats += SearchStats{steps, games};
+                _table_stats.hits[turn]++;
+                return false;
+            }
+            if (_cache != nullptr and _cache->probe(key, steps, games)) {
+                _stats += SearchStats{steps, games};
+                _table_stats.cached[turn]++;
+                if (_table != nullptr) {
+                    _table->store(key, steps, games);
                 }
+                return false;
             }
         }
+        if (_endgame_turn != 0 and turn >= _endgame_turn and
+            _prefixes == nullptr) {
+            SearchStats subtree;
+            if (_endgame->count(_field, subtree.total_steps,
+                                subtree.complete_games)) {
+                _stats += subtree;
+                _table_stats.independent[turn]++;
+                if (memoized) {
+                    store_subtree(_entry_keys[turn], subtree);
+                }
+                return false;
+            }
+        }
+        if (memoized) {
+            _table_stats.expanded[turn]++;
+            _entry_stats[turn] = _stats;
+            _entry_valid[turn] = true;
+        }
+        // split 中の途中経過は, 部分木を探索する側で出力する
+        if (_prefixes == nullptr and _stats.total_steps % 100000 == 0) {
+            save_field(true);
+        }
+        _field.generate_moves(current_player(), _moves[turn]);
+        telemetry_counters.count_branching(_moves[turn].size());
+        if (_moves[turn].empty()) {
+            count_end();
+        }
+        _next[turn] = 0;
+        return true;
     }
 
-    /// @brief 各プレイヤーの保持するブロック集合に対し、各 mode
-    /// の各ブロックを割り当てる
-    void setup_blocks() {
-        // TOTAL_BLOCK_SIZE == BLOCK_SIZE * BLOCK_MODE_SIZE
-        for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
-            for (unsigned short mode = 0; mode < BLOCK_MODE_SIZE; mode++) {
-                Blocks blocks_impl = Blocks(mode);
-                for (unsigned short i = 0; i < BLOCK_SIZE; i++) {
-                    _blocks[player][BLOCK_MODE_SIZE * i + mode] =
-                        blocks_impl[i];
+    /// @brief 現在の局面を終局として _aggregates に数える
+    void count_end() {
+        if (_aggregates != nullptr) {
+            _aggregates->count_end(_field.state(), _path);
+        }
+    }
+
+    /// @brief キーが key の局面の部分木の集計 subtree を置換表と
+    /// キャッシュに登録する
+    void store_subtree(const SubtreeKey &key, const SearchStats &subtree) {
+        if (_table != nullptr) {
+            _table->store(key, subtree.total_steps, subtree.complete_games);
+        }
+        if (_cache != nullptr) {
+            _cache->store(key, subtree.total_steps, subtree.complete_games);
+        }
+    }
+
+    /// @brief 探索スタックが空になるまで, 再帰を使わずに
+    /// バックトラックでブロックを置く
+    void run() {
+        while (true) {
+            if (_checkpoint_interval != 0 and
+                _stats.total_steps >= _next_checkpoint) {
+                save_checkpoint();
+                _next_checkpoint = _stats.total_steps + _checkpoint_interval;
+            }
+            if (_telemetry != nullptr and --_telemetry_countdown == 0) {
+                report_telemetry();
+            }
+            const unsigned short turn = _field.current_turn;
+            if (_next[turn] == _moves[turn].size()) {
+                // この局面の合法手をすべて試したので, 部分木の集計を
+                // 置換表とキャッシュに登録して 1 手戻る
+                if ((_table != nullptr or _cache != nullptr) and
+                    _prefixes == nullptr and _entry_valid[turn]) {
+                    store_subtree(_entry_keys[turn],
+                                  _stats - _entry_stats[turn]);
+                }
+                if (turn == _root_turn) {
+                    return;
                 }
+                pop();
+                continue;
+            }
+            const Move move = _moves[turn][_next[turn]++];
+            _stats.total_steps++;
+            telemetry_counters.count_node(turn + 1, current_player());
+            if (_aggregates != nullptr) {
+                _aggregates->count_move(turn + 1, move);
+            }
+            // ブロックを配置
+            push(move);
+            if (!enter()) {
+                // ブロックを削除 (バックトラック)
+                pop();
             }
         }
     }
 
-    bool is_block_used(const std::array<bool, BLOCK_SIZE> &block) {
-        return std::all_of(block.begin(), block.end(),
-                           [](bool y) { return y; });
+    /// @brief count の本体. 現在の局面から remaining 手先までを数える
+    /// @param ply root からの手数
+    void count_nodes(unsigned short remaining, unsigned short ply,
+                     std::vector<unsigned long long> &counts) {
+        if (!pass_dead_players()) {
+            return;
+        }
+        const unsigned short turn = _field.current_turn;
+        const Player player = current_player();
+        if (remaining == 1) {
+            // 最後の 1 手は合法手を作らずに数だけを足す
+            counts[ply + 1] += _field.count_moves(player);
+            return;
+        }
+        std::vector<Move> &moves = _moves[turn];
+        _field.generate_moves(player, moves);
+        counts[ply + 1] += moves.size();
+        for (const Move &move : moves) {
+            push(move);
+            count_nodes(remaining - 1, ply + 1, counts);
+            pop();
+        }
+    }
+
+    /// @brief 最後に置いたブロックを取り除く
+    void pop() {
+        const Move move = _path.back();
+        _field.remove(move.position.x, move.position.y, move.orientation);
+        _path.pop_back();
     }
 
-    bool is_all_blocks_used() {
-        return std::all_of(_used.begin(), _used.end(),
-                           [this](const std::array<bool, BLOCK_SIZE> &block) {
-                               return is_block_used(block);
-                           });
+    /// @brief 前回からの telemetry_counters の増分を _telemetry に報告する
+    void report_telemetry() {
+        _telemetry_countdown = TELEMETRY_REPORT_STEPS;
+        if (_telemetry == nullptr) {
+            return;
+        }
+        TelemetryCounters delta = telemetry_counters;
+        delta -= _telemetry_reported;
+        _telemetry_reported = telemetry_counters;
+        _telemetry->report(delta);
+    }
+
+    /// @brief 現在の探索スタックをチェックポイントとして書き出す.
+    /// 先に局面のファイルをディスクまで書き出し, そのレコード数と終端を
+    /// 記録する. 再開時はそこまでの局面が残り, 以降の局面は書き直される
+    void save_checkpoint() const {
+        Checkpoint checkpoint;
+        checkpoint.fingerprint = rule_fingerprint<Rules>();
+        const std::size_t root_size = _path.size() -
+                                      (_field.current_turn - _root_turn);
+        checkpoint.root.assign(_path.begin(), _path.begin() + root_size);
+        checkpoint.path.assign(_path.begin() + root_size, _path.end());
+        for (unsigned short turn = _root_turn; turn <= _field.current_turn;
+             turn++) {
+            checkpoint.next.push_back(_next[turn]);
+        }
+        for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            checkpoint.used[player] = _field.state().used_blocks(player);
+        }
+        checkpoint.total_steps = _stats.total_steps;
+        checkpoint.complete_games = _stats.complete_games;
+        if (_output != nullptr) {
+            _output->sync();
+            checkpoint.output_records = _output->size();
+            checkpoint.output_offset = _output->offset();
+        }
+        checkpoint.save(_checkpoint_path);
+    }
+
+    static bool is_same_move(const Move &lhs, const Move &rhs) {
+        return lhs.orientation == rhs.orientation and
+               lhs.position.x == rhs.position.x and
+               lhs.position.y == rhs.position.y;
     }
 };
+
+/// @brief 通常のブロックスの探索
+using Solver = BasicSolver<ClassicRules>;
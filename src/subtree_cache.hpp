@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#pragma once
+#include "game_state.hpp"
+#include "rules.hpp"
+
+// キャッシュのファイル形式の版. 形式か集計の意味を変えたら上げる
+constexpr std::uint32_t SUBTREE_CACHE_VERSION = 1;
+
+/// @brief SubtreeCache のキー. 局面ごとに独立な 64 bit の値 2 つで,
+/// first でバケットを選び, 両方が一致したエントリだけを使う
+struct SubtreeKey {
+    std::uint64_t first = 0;
+    std::uint64_t second = 0;
+};
+
+/// @brief 局面 (各プレイヤーの盤面, 使っていないブロック, 手番) のキー.
+/// Zobrist ハッシュと違ってフィールドの実装によらず盤面の値だけから決まるので,
+/// ファイルに残して次の実行で引ける.
+/// turn と passed は盤面から決まるので含めない
+template <class Rules>
+constexpr SubtreeKey subtree_key(const BasicGameState<Rules> &state) {
+    using Board = typename BasicGameState<Rules>::Board;
+    SubtreeKey key{0x243f6a8885a308d3ULL, 0x13198a2e03707344ULL};
+    const auto absorb = [&key](std::uint64_t value) {
+        key.first = absorb_hash(key.first, value);
+        key.second = absorb_hash(key.second ^ 0xa4093822299f31d0ULL, value);
+    };
+    absorb(state.player);
+    for (unsigned short player = 0; player < Rules::PLAYER_SIZE; player++) {
+        absorb(state.remaining[player]);
+        for (std::size_t i = 0; i < Board::WORD_SIZE; i++) {
+            absorb(state.boards[player].word(i));
+        }
+    }
+    return key;
+}
+
+/// @brief キャッシュのファイルに書くルールの指紋 (rule_fingerprint).
+/// 別のルールで作ったファイルを開こうとしたらエラーにする
+template <class Rules>
+constexpr std::uint64_t subtree_cache_fingerprint() {
+    return rule_fingerprint<Rules>(SUBTREE_CACHE_VERSION);
+}
+
+/// @brief 局面のキーから部分木の集計 (ノード数と完全なゲームの数) を引く,
+/// ファイルに残る固定サイズのハッシュ表. ファイルを mmap (MAP_SHARED)
+/// して読み書きするので, 次の実行や同時に動く別のプロセス (シャード) とも
+/// 共有できる. 読み書きは TranspositionTable と同じくロックを取らず,
+/// 書き込みが混ざって壊れたエントリは検査値の不一致で捨てる.
+///
+/// バケットはエントリ 4 つからなり, 満杯なら最も小さい部分木を上書きする.
+/// min_steps より小さい部分木は登録しない (探索し直した方が安い)
+class SubtreeCache {
+    // ファイルの先頭のページ
+    struct Header {
+        std::uint64_t magic;
+        std::uint32_t version;
+        std::uint32_t bucket_entries;
+        std::uint64_t fingerprint;
+        std::uint64_t bucket_size;
+    };
+    // check = key.first ^ steps ^ games, verify = key.second ^ steps ^ games.
+    // steps が 0 なら空き
+    struct Entry {
+        std::uint64_t check;
+        std::uint64_t verify;
+        std::uint64_t steps;
+        std::uint64_t games;
+    };
+    static constexpr std::size_t BUCKET_ENTRIES = 4;
+    struct Bucket {
+        Entry entries[BUCKET_ENTRIES];
+    };
+    static constexpr std::uint64_t MAGIC = 0x4548434143425553ULL;  // SUBCACHE
+    static constexpr std::size_t HEADER_SIZE = 4096;
+
+    int _fd = -1;
+    void *_map = nullptr;
+    std::size_t _map_size = 0;
+    Bucket *_buckets = nullptr;
+    std::size_t _mask = 0;
+    std::uint64_t _min_steps;
+
+   public:
+    /// @brief path のキャッシュを開く. 無ければ megabytes MiB 以内で,
+    /// バケット数が 2 冪になるよう作る. 既にあればその大きさのまま使い,
+    /// fingerprint (subtree_cache_fingerprint) が違えばエラーにする
+    SubtreeCache(const std::string &path, std::size_t megabytes,
+                 std::uint64_t fingerprint, std::uint64_t min_steps = 1)
+        : _min_steps(std::max<std::uint64_t>(min_steps, 1)) {
+        _fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (_fd < 0) {
+            throw std::runtime_error("Failed to open subtree cache: " + path);
+        }
+        try {
+            // 同時に開いた別のプロセスとファイルの作成が重ならないようにする
+            ::flock(_fd, LOCK_EX);
+            open_file(path, megabytes, fingerprint);
+            ::flock(_fd, LOCK_UN);
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    SubtreeCache(const SubtreeCache &) = delete;
+    SubtreeCache &operator=(const SubtreeCache &) = delete;
+    ~SubtreeCache() { close(); }
+
+    std::size_t size() const { return (_mask + 1) * BUCKET_ENTRIES; }
+    std::uint64_t min_steps() const { return _min_steps; }
+
+    /// @brief key の局面が登録されていれば, その部分木の集計を返す
+    bool probe(const SubtreeKey &key, std::uint64_t &steps,
+               std::uint64_t &games) const {
+        Bucket &bucket = _buckets[key.first & _mask];
+        for (Entry &entry : bucket.entries) {
+            if (read(entry, key, steps, games)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief key の局面の部分木の集計を登録する. min_steps より小さい
+    /// 部分木と, バケットのどのエントリよりも小さい部分木は登録しない
+    void store(const SubtreeKey &key, std::uint64_t steps,
+               std::uint64_t games) {
+        if (steps < _min_steps) {
+            return;
+        }
+        Bucket &bucket = _buckets[key.first & _mask];
+        Entry *victim = nullptr;
+        std::uint64_t victim_steps = 0;
+        for (Entry &entry : bucket.entries) {
+            std::uint64_t s, g;
+            if (read(entry, key, s, g)) {
+                return;
+            }
+            s = load(entry.steps);
+            if (victim == nullptr or s < victim_steps) {
+                victim = &entry;
+                victim_steps = s;
+            }
+        }
+        if (steps >= victim_steps) {
+            write(*victim, key, steps, games);
+        }
+    }
+
+    /// @brief 書き込んだ内容をファイルに反映する
+    void flush() {
+        if (_map != nullptr) {
+            ::msync(_map, _map_size, MS_SYNC);
+        }
+    }
+
+   private:
+    void open_file(const std::string &path, std::size_t megabytes,
+                   std::uint64_t fingerprint) {
+        struct stat status;
+        if (::fstat(_fd, &status) != 0) {
+            throw std::runtime_error("Failed to stat subtree cache: " + path);
+        }
+        const bool created = status.st_size == 0;
+        std::size_t bucket_size = 1;
+        if (created) {
+            while (bucket_size * 2 * sizeof(Bucket) <= (megabytes << 20)) {
+                bucket_size *= 2;
+            }
+            _map_size = HEADER_SIZE + bucket_size * sizeof(Bucket);
+            if (::ftruncate(_fd, _map_size) != 0) {
+                throw std::runtime_error("Failed to resize subtree cache: " +
+                                         path);
+            }
+        } else {
+            _map_size = status.st_size;
+        }
+        if (_map_size < HEADER_SIZE) {
+            throw std::runtime_error("Broken subtree cache: " + path);
+        }
+        _map = ::mmap(nullptr, _map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      _fd, 0);
+        if (_map == MAP_FAILED) {
+            _map = nullptr;
+            throw std::runtime_error("Failed to map subtree cache: " + path);
+        }
+        Header &header = *static_cast<Header *>(_map);
+        if (created) {
+            header.version = SUBTREE_CACHE_VERSION;
+            header.bucket_entries = BUCKET_ENTRIES;
+            header.fingerprint = fingerprint;
+            header.bucket_size = bucket_size;
+            header.magic = MAGIC;
+        }
+        if (header.magic != MAGIC or header.version != SUBTREE_CACHE_VERSION or
+            header.bucket_entries != BUCKET_ENTRIES) {
+            throw std::runtime_error("Unsupported subtree cache: " + path);
+        }
+        if (header.fingerprint != fingerprint) {
+            throw std::runtime_error("Subtree cache for other rules: " + path);
+        }
+        bucket_size = header.bucket_size;
+        if (bucket_size == 0 or (bucket_size & (bucket_size - 1)) != 0 or
+            _map_size != HEADER_SIZE + bucket_size * sizeof(Bucket)) {
+            throw std::runtime_error("Broken subtree cache: " + path);
+        }
+        _buckets = reinterpret_cast<Bucket *>(static_cast<char *>(_map) +
+                                              HEADER_SIZE);
+        _mask = bucket_size - 1;
+    }
+
+    void close() {
+        if (_map != nullptr) {
+            flush();
+            ::munmap(_map, _map_size);
+            _map = nullptr;
+        }
+        if (_fd >= 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+    }
+
+    static std::uint64_t load(std::uint64_t &value) {
+        return std::atomic_ref<std::uint64_t>(value).load(
+            std::memory_order_relaxed);
+    }
+
+    static void save(std::uint64_t &value, std::uint64_t x) {
+        std::atomic_ref<std::uint64_t>(value).store(x,
+                                                    std::memory_order_relaxed);
+    }
+
+    static bool read(Entry &entry, const SubtreeKey &key, std::uint64_t &steps,
+                     std::uint64_t &games) {
+        const std::uint64_t check = load(entry.check);
+        const std::uint64_t verify = load(entry.verify);
+        const std::uint64_t s = load(entry.steps);
+        const std::uint64_t g = load(entry.games);
+        if (s == 0 or (check ^ s ^ g) != key.first or
+            (verify ^ s ^ g) != key.second) {
+            return false;
+        }
+        steps = s;
+        games = g;
+        return true;
+    }
+
+    static void write(Entry &entry, const SubtreeKey &key, std::uint64_t steps,
+                      std::uint64_t games) {
+        save(entry.check, key.first ^ steps ^ games);
+        save(entry.verify, key.second ^ steps ^ games);
+        save(entry.steps, steps);
+        save(entry.games, games);
+    }
+};
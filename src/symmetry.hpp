@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#pragma once
+#include "field.hpp"
+#include "move.hpp"
+#include "parallel_solver.hpp"
+#include "pieces.hpp"
+#include "players.hpp"
+#include "result_stream.hpp"
+#include "rules.hpp"
+#include "solver.hpp"
+
+/// @brief フィールドの対称変換 (回転と裏返し) の 1 つ. mode は transform
+/// と同じで, マスの座標に同じ回転と裏返しを施してからフィールドに収まるよう
+/// 平行移動する.
+/// - orientations[o]: 向き o のブロックを変換した向き
+/// - players[p]: Rules::START_POSITIONS[p] を変換した開始マスのプレイヤー.
+///   開始マスに移らないものがあれば valid が false
+template <class Rules>
+struct BoardSymmetry {
+    static constexpr std::size_t FIELD_WIDTH = Rules::FIELD_WIDTH;
+    static constexpr unsigned short PLAYER_SIZE = Rules::PLAYER_SIZE;
+
+    unsigned short mode = 0;
+    std::array<unsigned short, ORIENTATION_SIZE> orientations{};
+    std::array<unsigned short, PLAYER_SIZE> players{};
+    bool valid = true;
+
+    constexpr Position apply(const Position &position) const {
+        const short last = FIELD_WIDTH - 1;
+        short x = position.x;
+        short y = position.y;
+        if (mode >= 4) {
+            y = last - y;
+        }
+        // 90 度回転を mode % 4 回行う
+        for (unsigned short r = 0; r < mode % 4; r++) {
+            const short rotated_x = last - y;
+            y = x;
+            x = rotated_x;
+        }
+        return Position(x, y);
+    }
+
+    /// @brief 変換した盤面での同じ配置. 左上は変換したマスの最小の座標
+    Move apply(const Move &move) const {
+        const Orientation &orientation = ORIENTATIONS[move.orientation];
+        unsigned short x = FIELD_WIDTH, y = FIELD_WIDTH;
+        for (unsigned short i = 0; i < orientation.cell_size; i++) {
+            const Position cell =
+                apply(Position(move.position.x + orientation.cells[i].x,
+                               move.position.y + orientation.cells[i].y));
+            x = std::min(x, cell.x);
+            y = std::min(y, cell.y);
+        }
+        return Move(orientations[move.orientation], Position(x, y));
+    }
+
+    /// @brief 手番の順を含めて探索木を自身に移すかどうか. 手番は
+    /// プレイヤーの番号順に回るので, どのプレイヤーも動かさないものに限る
+    constexpr bool preserves_tree() const {
+        if (!valid) {
+            return false;
+        }
+        for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            if (players[player] != player) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// ルール Rules のフィールドの 8 通りの対称変換. 添字は mode
+template <class Rules>
+constexpr std::array<BoardSymmetry<Rules>, BLOCK_MODE_SIZE>
+    BOARD_SYMMETRIES = [] {
+    constexpr unsigned short PLAYER_SIZE = Rules::PLAYER_SIZE;
+    constexpr const auto &START_POSITIONS = Rules::START_POSITIONS;
+    std::array<BoardSymmetry<Rules>, BLOCK_MODE_SIZE> symmetries{};
+    for (unsigned short mode = 0; mode < BLOCK_MODE_SIZE; mode++) {
+        BoardSymmetry<Rules> &symmetry = symmetries[mode];
+        symmetry.mode = mode;
+        for (unsigned short o = 0; o < ORIENTATION_SIZE; o++) {
+            const Orientation image = transform(ORIENTATIONS[o], mode);
+            for (unsigned short other = 0; other < ORIENTATION_SIZE; other++) {
+                if (ORIENTATIONS[other].block == image.block and
+                    ORIENTATIONS[other] == image) {
+                    symmetry.orientations[o] = other;
+                }
+            }
+        }
+        for (unsigned short player = 0; player < PLAYER_SIZE; player++) {
+            const Position start = symmetry.apply(START_POSITIONS[player]);
+            symmetry.valid &= std::any_of(
+                START_POSITIONS.begin(), START_POSITIONS.end(),
+                [&](const Position &other) {
+                    return other.x == start.x and other.y == start.y;
+                });
+            for (unsigned short other = 0; other < PLAYER_SIZE; other++) {
+                if (START_POSITIONS[other].x == start.x and
+                    START_POSITIONS[other].y == start.y) {
+                    symmetry.players[player] = other;
+                }
+            }
+        }
+    }
+    return symmetries;
+}();
+
+/// @brief 探索木を自身に移す対称変換 (恒等変換を含む)
+template <class Rules = ClassicRules>
+std::vector<BoardSymmetry<Rules>> tree_symmetries() {
+    std::vector<BoardSymmetry<Rules>> symmetries;
+    for (const BoardSymmetry<Rules> &symmetry : BOARD_SYMMETRIES<Rules>) {
+        if (symmetry.preserves_tree()) {
+            symmetries.push_back(symmetry);
+        }
+    }
+    return symmetries;
+}
+
+/// @brief 対称な手順の代表と, 同じ軌道に入る手順の数
+struct SymmetricPrefix {
+    std::vector<Move> moves;
+    unsigned short multiplicity = 1;
+};
+
+/// @brief 手順を 1 手ずつ (向き, x, y) の辞書順で比べる
+inline bool is_less_sequence(const std::vector<Move> &lhs,
+                             const std::vector<Move> &rhs) {
+    return std::lexicographical_compare(
+        lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const Move &a, const Move &b) {
+            if (a.orientation != b.orientation) {
+                return a.orientation < b.orientation;
+            }
+            return a.position.x != b.position.x ? a.position.x < b.position.x
+                                                : a.position.y < b.position.y;
+        });
+}
+
+/// @brief prefixes を symmetries で移り合う軌道に分け, 各軌道で辞書順最小の
+/// 手順だけを残す. 移した手順も合法手の手順で部分木の大きさも同じなので,
+/// 代表の部分木の集計を multiplicity 倍すれば全体の集計になる
+template <class Rules>
+std::vector<SymmetricPrefix> canonical_prefixes(
+    const std::vector<std::vector<Move>> &prefixes,
+    const std::vector<BoardSymmetry<Rules>> &symmetries) {
+    std::vector<SymmetricPrefix> result;
+    std::vector<std::vector<Move>> images;
+    for (const std::vector<Move> &prefix : prefixes) {
+        images.clear();
+        bool canonical = true;
+        for (const BoardSymmetry<Rules> &symmetry : symmetries) {
+            std::vector<Move> image;
+            for (const Move &move : prefix) {
+                image.push_back(symmetry.apply(move));
+            }
+            canonical &= !is_less_sequence(image, prefix);
+            images.push_back(std::move(image));
+        }
+        if (!canonical) {
+            continue;
+        }
+        std::sort(images.begin(), images.end(), is_less_sequence);
+        const auto unique_end = std::unique(
+            images.begin(), images.end(),
+            [](const std::vector<Move> &lhs, const std::vector<Move> &rhs) {
+                return !is_less_sequence(lhs, rhs) and
+                       !is_less_sequence(rhs, lhs);
+            });
+        result.push_back(
+            {prefix, static_cast<unsigned short>(unique_end - images.begin())});
+    }
+    return result;
+}
+
+/// @brief ルール Rules で初手から depth 手目までを展開し, 探索木の対称変換で移り合う
+/// 手順のうち代表だけを探索して, 集計を軌道の大きさ倍する.
+/// 集計は全探索と一致するが, 出力する局面は代表の部分木のものだけになる.
+/// depth 手目までに終わった局面は output_path-split に書き出す.
+/// thread_size が 2 以上なら, 各部分木をさらに ParallelSolver で分割する
+template <class Rules = ClassicRules>
+SearchStats solve_symmetric(unsigned short depth, unsigned short thread_size,
+                            unsigned short split_depth,
+                            const std::string &output_path,
+                            TranspositionTable *table = nullptr,
+                            TelemetryLog *telemetry = nullptr,
+                            SubtreeCache *cache = nullptr) {
+    BasicSolver<Rules> splitter;
+    ResultWriter split_writer(output_path + "-split",
+                              rule_fingerprint<Rules>());
+    splitter.set_output(&split_writer);
+    std::vector<std::vector<Move>> prefixes;
+    splitter.split({}, depth, prefixes);
+    split_writer.close();
+    SearchStats total = splitter.stats();
+
+    std::optional<ResultWriter> writer;
+    if (thread_size <= 1) {
+        writer.emplace(output_path, rule_fingerprint<Rules>());
+    }
+    for (const SymmetricPrefix &prefix :
+         canonical_prefixes(prefixes, tree_symmetries<Rules>())) {
+        SearchStats stats;
+        if (thread_size <= 1) {
+            BasicSolver<Rules> solver;
+            solver.set_output(&*writer);
+            solver.set_transposition_table(table);
+            solver.set_telemetry(telemetry);
+            solver.set_subtree_cache(cache);
+            solver.solve(prefix.moves);
+            stats = solver.stats();
+        } else {
+            BasicParallelSolver<Rules> solver(thread_size, split_depth,
+                                              output_path, table);
+            solver.set_telemetry(telemetry);
+            solver.set_subtree_cache(cache);
+            solver.solve(prefix.moves);
+            stats = solver.stats();
+        }
+        total.total_steps += stats.total_steps * prefix.multiplicity;
+        total.complete_games += stats.complete_games * prefix.multiplicity;
+    }
+    return total;
+}
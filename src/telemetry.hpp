@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#pragma once
+#include "pieces.hpp"
+#include "players.hpp"
+
+#ifdef BLOKUS_CYCLE_TIMERS
+#include <x86intrin.h>
+#endif
+
+// 深さ (ターン数) ごとの集計の大きさ. 0 手目から全ブロックを置き切るまで
+constexpr std::size_t TELEMETRY_DEPTH_SIZE = PLAYER_SIZE * BLOCK_SIZE + 1;
+// 分岐数のヒストグラムの区間の数. 区間 0 は合法手なし,
+// 区間 k (k >= 1) は合法手の数が [2^(k-1), 2^k) の局面
+constexpr std::size_t BRANCHING_BUCKET_SIZE = 17;
+
+/// @brief 合法手の生成で, ブロックを置けないと判定した理由.
+/// 数えるのは, 手番のプレイヤーの使っていない向きのブロックを,
+/// 左上がフィールドの中に来るように置いたもののうち,
+/// - フィールドに収まるものすべて
+/// - はみ出るもののうち, 使える角 (初手では開始マス) を覆うもの
+/// で, どのフィールドの実装でもこの集合で数える. 使える角が無いプレイヤー
+/// の合法手は調べないので数えない
+enum RejectReason {
+    // 使える角を覆うが, ブロックがフィールドからはみ出る
+    REJECT_OUT_OF_FIELD = 0,
+    // 使える角を覆うが, 他のブロックが置かれているマスに重なる
+    REJECT_OCCUPIED = 1,
+    // 使える角と空いているマスだけを覆うが, 自分のブロックと上下左右で接する
+    REJECT_EDGE_ADJACENT = 2,
+    // フィールドに収まるが, 使える角を覆わない (自分のブロックと斜めに
+    // 接しないか, 初手では開始マスを覆わない)
+    REJECT_NO_DIAGONAL_CONTACT = 3,
+    REJECT_REASON_SIZE = 4
+};
+
+/// @brief BLOKUS_CYCLE_TIMERS を定義してビルドしたときに,
+/// 所要サイクル数を測る関数
+enum TimerTarget {
+    TIMER_IS_ABLE_TO_PLACE = 0,
+    TIMER_GENERATE_MOVES = 1,
+    TIMER_PLACE = 2,
+    TIMER_REMOVE = 3,
+    TIMER_TARGET_SIZE = 4
+};
+
+/// @brief 探索の計測値. スレッドごとに telemetry_counters に数え,
+/// TelemetryLog で足し合わせて書き出す
+struct TelemetryCounters {
+    // depth_nodes[i] := ターン i の局面 (i 個目のブロックを置いた局面) の数
+    std::array<unsigned long long, TELEMETRY_DEPTH_SIZE> depth_nodes{};
+    // player_nodes[p] := プレイヤー p がブロックを置いた回数
+    std::array<unsigned long long, PLAYER_SIZE> player_nodes{};
+    // branching[k] := 合法手の数が区間 k に入る局面の数
+    std::array<unsigned long long, BRANCHING_BUCKET_SIZE> branching{};
+    // rejections[r] := 理由 r で置けないと判定した回数
+    std::array<unsigned long long, REJECT_REASON_SIZE> rejections{};
+    // timer_calls[t], timer_cycles[t] := 関数 t の呼び出し回数と合計サイクル数
+    std::array<unsigned long long, TIMER_TARGET_SIZE> timer_calls{};
+    std::array<unsigned long long, TIMER_TARGET_SIZE> timer_cycles{};
+
+    void count_node(unsigned short turn, const Player &player) {
+        depth_nodes[turn]++;
+        player_nodes[player]++;
+    }
+
+    void count_branching(std::size_t move_size) {
+        branching[std::min<std::size_t>(std::bit_width(move_size),
+                                         BRANCHING_BUCKET_SIZE - 1)]++;
+    }
+
+    void reject(RejectReason reason, unsigned long long count = 1) {
+        rejections[reason] += count;
+    }
+
+    unsigned long long nodes() const {
+        unsigned long long total = 0;
+        for (unsigned long long count : depth_nodes) {
+            total += count;
+        }
+        return total;
+    }
+
+    TelemetryCounters &operator+=(const TelemetryCounters &other) {
+        add(depth_nodes, other.depth_nodes);
+        add(player_nodes, other.player_nodes);
+        add(branching, other.branching);
+        add(rejections, other.rejections);
+        add(timer_calls, other.timer_calls);
+        add(timer_cycles, other.timer_cycles);
+        return *this;
+    }
+
+    TelemetryCounters &operator-=(const TelemetryCounters &other) {
+        subtract(depth_nodes, other.depth_nodes);
+        subtract(player_nodes, other.player_nodes);
+        subtract(branching, other.branching);
+        subtract(rejections, other.rejections);
+        subtract(timer_calls, other.timer_calls);
+        subtract(timer_cycles, other.timer_cycles);
+        return *this;
+    }
+
+   private:
+    template <std::size_t N>
+    static void add(std::array<unsigned long long, N> &lhs,
+                    const std::array<unsigned long long, N> &rhs) {
+        for (std::size_t i = 0; i < N; i++) {
+            lhs[i] += rhs[i];
+        }
+    }
+
+    template <std::size_t N>
+    static void subtract(std::array<unsigned long long, N> &lhs,
+                         const std::array<unsigned long long, N> &rhs) {
+        for (std::size_t i = 0; i < N; i++) {
+            lhs[i] -= rhs[i];
+        }
+    }
+};
+
+// 各スレッドの計測値. 探索中はロックを取らずにこれを増やす
+inline thread_local TelemetryCounters telemetry_counters;
+
+#ifdef BLOKUS_CYCLE_TIMERS
+/// @brief スコープを抜けるまでのサイクル数を telemetry_counters に足す
+class CycleTimer {
+    TimerTarget _target;
+    unsigned long long _start;
+
+   public:
+    explicit CycleTimer(TimerTarget target)
+        : _target(target), _start(__rdtsc()) {}
+    ~CycleTimer() {
+        telemetry_counters.timer_calls[_target]++;
+        telemetry_counters.timer_cycles[_target] += __rdtsc() - _start;
+    }
+};
+#define TELEMETRY_TIMER(target) CycleTimer cycle_timer_(target)
+#else
+#define TELEMETRY_TIMER(target)
+#endif
+
+/// @brief 各スレッドの計測値の差分を足し合わせ, interval
+/// 秒ごとに 1 行の JSON として file_path に追記する
+class TelemetryLog {
+    std::ofstream _file;
+    double _interval;
+    std::mutex _mutex;
+    TelemetryCounters _total;
+    std::chrono::steady_clock::time_point _start, _last_write;
+    unsigned long long _last_nodes = 0;
+    // 探索する部分木のノード数の推定値. 0 なら残り時間を書き出さない
+    double _estimated_nodes = 0;
+
+   public:
+    TelemetryLog(const std::string &file_path, double interval)
+        : _file(file_path, std::ios::app),
+          _interval(interval),
+          _start(std::chrono::steady_clock::now()),
+          _last_write(_start) {
+        if (!_file) {
+            throw std::runtime_error("Failed to open file: " + file_path);
+        }
+    }
+
+    /// @brief 前回の報告からの差分 delta を足す. 前回の書き出しから
+    /// interval 秒以上経っていれば書き出す
+    void report(const TelemetryCounters &delta) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _total += delta;
+        if (seconds_since(_last_write) >= _interval) {
+            write_line();
+        }
+    }
+
+    /// @brief 探索する部分木のノード数の推定値 (TreeEstimator の total_steps)
+    /// を設定する. 以降は推定値と, これまでの平均の速さで探索したときの
+    /// 残り秒数も書き出す
+    void set_estimated_nodes(double nodes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _estimated_nodes = nodes;
+    }
+
+    ~TelemetryLog() { close(); }
+
+    /// @brief 最後の集計を書き出して閉じる
+    void close() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_file.is_open()) {
+            return;
+        }
+        write_line();
+        _file.close();
+    }
+
+   private:
+    double seconds_since(std::chrono::steady_clock::time_point time) const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             time)
+            .count();
+    }
+
+    void write_line() {
+        static constexpr const char *REJECT_REASON_NAMES[REJECT_REASON_SIZE] =
+            {"out_of_field", "occupied", "edge_adjacent",
+             "no_diagonal_contact"};
+        static constexpr const char *TIMER_TARGET_NAMES[TIMER_TARGET_SIZE] = {
+            "is_able_to_place", "generate_moves", "place", "remove"};
+
+        const double elapsed = seconds_since(_start);
+        const double interval = seconds_since(_last_write);
+        const unsigned long long nodes = _total.nodes();
+        _file << "{\"elapsed\":" << elapsed << ",\"nodes\":" << nodes
+              << ",\"nodes_per_sec\":"
+              << (interval > 0 ? (nodes - _last_nodes) / interval : 0.0);
+        if (_estimated_nodes > 0) {
+            const double rate = elapsed > 0 ? nodes / elapsed : 0.0;
+            _file << ",\"estimated_nodes\":" << _estimated_nodes
+                  << ",\"eta_seconds\":"
+                  << (rate > 0 ? std::max(_estimated_nodes - nodes, 0.0) / rate
+                               : 0.0);
+        }
+        _file << ",\"depth_nodes\":";
+        write_array(_total.depth_nodes);
+        _file << ",\"player_nodes\":";
+        write_array(_total.player_nodes);
+        _file << ",\"branching\":";
+        write_array(_total.branching);
+        _file << ",\"rejections\":{";
+        for (std::size_t reason = 0; reason < REJECT_REASON_SIZE; reason++) {
+            _file << (reason == 0 ? "" : ",") << '"'
+                  << REJECT_REASON_NAMES[reason]
+                  << "\":" << _total.rejections[reason];
+        }
+        _file << '}';
+#ifdef BLOKUS_CYCLE_TIMERS
+        _file << ",\"timers\":{";
+        for (std::size_t target = 0; target < TIMER_TARGET_SIZE; target++) {
+            _file << (target == 0 ? "" : ",") << '"'
+                  << TIMER_TARGET_NAMES[target]
+                  << "\":{\"calls\":" << _total.timer_calls[target]
+                  << ",\"cycles\":" << _total.timer_cycles[target] << '}';
+        }
+        _file << '}';
+#else
+        (void)TIMER_TARGET_NAMES;
+#endif
+        _file << "}\n";
+        _file.flush();
+        _last_write = std::chrono::steady_clock::now();
+        _last_nodes = nodes;
+    }
+
+    template <std::size_t N>
+    void write_array(const std::array<unsigned long long, N> &values) {
+        _file << '[';
+        for (std::size_t i = 0; i < N; i++) {
+            _file << (i == 0 ? "" : ",") << values[i];
+        }
+        _file << ']';
+    }
+};
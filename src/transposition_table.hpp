@@ -0,0 +1,93 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#pragma once
+#include "subtree_cache.hpp"
+
+/// @brief 局面のキー (SubtreeKey) から部分木の集計結果 (ノード数と完全な
+/// ゲームの数) を引く固定サイズの置換表. 複数スレッドから同時に読み書きでき,
+/// ロックは取らない. エントリは key.first ^ steps ^ games と
+/// key.second ^ steps ^ games を検査値として持ち, 両方が一致したものだけを
+/// 使う. 書き込みが混ざって壊れたエントリも検査値の不一致で捨てる
+/// (Hyatt の lockless hashing).
+/// バケットを選ぶ first と独立な second も照合するので, 別の局面の集計を
+/// 返すのは 128 bit のキーが衝突したときだけになる.
+///
+/// バケットはエントリ 2 つからなり, 1 つ目はより大きい部分木を残し,
+/// 2 つ目は常に上書きする.
+class TranspositionTable {
+    struct Entry {
+        std::atomic<std::uint64_t> check{0};
+        std::atomic<std::uint64_t> verify{0};
+        std::atomic<std::uint64_t> steps{0};
+        std::atomic<std::uint64_t> games{0};
+    };
+    struct Bucket {
+        Entry deep;
+        Entry recent;
+    };
+
+    std::unique_ptr<Bucket[]> _buckets;
+    std::size_t _mask = 0;
+
+   public:
+    /// @brief megabytes MiB 以内で, バケット数が 2 冪になるよう確保する
+    explicit TranspositionTable(std::size_t megabytes) {
+        std::size_t size = 1;
+        while (size * 2 * sizeof(Bucket) <= (megabytes << 20)) {
+            size *= 2;
+        }
+        _buckets = std::make_unique<Bucket[]>(size);
+        _mask = size - 1;
+    }
+
+    std::size_t size() const { return (_mask + 1) * 2; }
+
+    /// @brief key の局面が登録されていれば, その部分木の集計を返す
+    bool probe(const SubtreeKey &key, std::uint64_t &steps,
+               std::uint64_t &games) const {
+        const Bucket &bucket = _buckets[key.first & _mask];
+        return read(bucket.deep, key, steps, games) or
+               read(bucket.recent, key, steps, games);
+    }
+
+    /// @brief key の局面の部分木の集計を登録する
+    void store(const SubtreeKey &key, std::uint64_t steps,
+               std::uint64_t games) {
+        Bucket &bucket = _buckets[key.first & _mask];
+        const std::uint64_t deep_steps =
+            bucket.deep.steps.load(std::memory_order_relaxed);
+        if (steps >= deep_steps) {
+            write(bucket.deep, key, steps, games);
+        } else {
+            write(bucket.recent, key, steps, games);
+        }
+    }
+
+   private:
+    static bool read(const Entry &entry, const SubtreeKey &key,
+                     std::uint64_t &steps, std::uint64_t &games) {
+        const std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+        const std::uint64_t verify =
+            entry.verify.load(std::memory_order_relaxed);
+        const std::uint64_t s = entry.steps.load(std::memory_order_relaxed);
+        const std::uint64_t g = entry.games.load(std::memory_order_relaxed);
+        if ((check ^ s ^ g) != key.first or (verify ^ s ^ g) != key.second) {
+            return false;
+        }
+        steps = s;
+        games = g;
+        return true;
+    }
+
+    static void write(Entry &entry, const SubtreeKey &key, std::uint64_t steps,
+                      std::uint64_t games) {
+        entry.check.store(key.first ^ steps ^ games,
+                          std::memory_order_relaxed);
+        entry.verify.store(key.second ^ steps ^ games,
+                           std::memory_order_relaxed);
+        entry.steps.store(steps, std::memory_order_relaxed);
+        entry.games.store(games, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "pieces.hpp"
+#include "players.hpp"
+
+/// @brief 局面の Zobrist ハッシュに使う乱数表.
+/// 盤面は (プレイヤー, マス), 使用済みブロックは (プレイヤー, ブロック),
+/// 手番はプレイヤーごとの乱数の XOR で表す
+template <std::size_t CELL_SIZE>
+struct ZobristKeys {
+    std::array<std::array<std::uint64_t, CELL_SIZE>, PLAYER_SIZE> cells{};
+    std::array<std::array<std::uint64_t, BLOCK_SIZE>, PLAYER_SIZE> blocks{};
+    std::array<std::uint64_t, PLAYER_SIZE> turns{};
+
+    /// @brief splitmix64 で乱数表をコンパイル時に埋める
+    constexpr ZobristKeys() {
+        std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+        auto next = [&state] {
+            state += 0x9e3779b97f4a7c15ULL;
+            std::uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        };
+        for (auto &player_keys : cells) {
+            for (std::uint64_t &key : player_keys) {
+                key = next();
+            }
+        }
+        for (auto &player_keys : blocks) {
+            for (std::uint64_t &key : player_keys) {
+                key = next();
+            }
+        }
+        for (std::uint64_t &key : turns) {
+            key = next();
+        }
+    }
+};